@@ -1,4 +1,5 @@
 #include "CritterFactory.h"
+#include <new>
 
 //Critter Factory
 CritterLogic* CritterFactory::createCritter(CritterType type, MapLogic& mapLogic, int level) {
@@ -14,4 +15,24 @@ CritterLogic* CritterFactory::createCritter(CritterType type, MapLogic& mapLogic
     default:
         return nullptr;
     }
+}
+
+// Critter storage is reused across types, so no type may add members
+static_assert(sizeof(SpeedyCritter) == sizeof(CritterLogic) && sizeof(TankyCritter) == sizeof(CritterLogic) &&
+              sizeof(StrongCritter) == sizeof(CritterLogic) && sizeof(BasicCritter) == sizeof(CritterLogic),
+              "critter types must all be the size of CritterLogic");
+
+CritterLogic* CritterFactory::createCritter(CritterType type, MapLogic& mapLogic, int level, void* storage) {
+    switch (type) {
+    case SPEEDY:
+        return ::new (storage) SpeedyCritter(mapLogic, level);
+    case TANKY:
+        return ::new (storage) TankyCritter(mapLogic, level);
+    case STRONG:
+        return ::new (storage) StrongCritter(mapLogic, level);
+    case BALANCED:
+        return ::new (storage) BasicCritter(mapLogic, level);
+    default:
+        return nullptr;
+    }
 }
\ No newline at end of file
@@ -10,6 +10,8 @@ class CritterFactory
 {
 public:
     static CritterLogic* createCritter(CritterType type, MapLogic& mapLogic, int level);
+    // Builds the critter in storage of sizeof(CritterLogic) bytes instead of on the heap.
+    static CritterLogic* createCritter(CritterType type, MapLogic& mapLogic, int level, void* storage);
 };
 
 #endif
\ No newline at end of file
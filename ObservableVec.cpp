@@ -3,7 +3,19 @@
 #include <vector>
 
 ObservableVec::ObservableVec() {
-    observers = new std::vector<ObserverVec*>;
+    observers = new ObserverList;
+}
+
+ObservableVec::~ObservableVec() {
+    delete observers;
+}
+
+ObservableVec::ObservableVec(const ObservableVec&) {
+    observers = new ObserverList;
+}
+
+ObservableVec& ObservableVec::operator=(const ObservableVec&) {
+    return *this;
 }
 
 void ObservableVec::Attach(ObserverVec* o) {
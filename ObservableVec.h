@@ -1,5 +1,6 @@
 #pragma once
 #include "ObserverVec.h"
+#include "memoryTracker.h"
 #include <vector>
 
 using namespace std;
@@ -7,14 +8,20 @@ using namespace std;
 // Forward declaration due to circular reference between Observer and Observable
 class ObserverVec;
 
+typedef vector<ObserverVec*, TrackedAllocator<ObserverVec*, MemorySubsystem::OBSERVERS>> ObserverList;
+
 class ObservableVec {
 public:
     virtual void Attach(ObserverVec* o);
     virtual void Detach(ObserverVec* o);
     virtual void Notify();
     ObservableVec();
+    virtual ~ObservableVec();
+    // Observers are registered per instance, so copies start with none.
+    ObservableVec(const ObservableVec& other);
+    ObservableVec& operator=(const ObservableVec& other);
 private:
-    vector<ObserverVec*>* observers;
+    ObserverList* observers;
 };
 
 
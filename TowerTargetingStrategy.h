@@ -1,7 +1,57 @@
+#pragma once
 #include "critterLogic.h"
+#include "spatialGrid.h"
 
-class TowerTargetingStrategy {
-public:
-    virtual CritterLogic* GetTargetCritter(std::vector<CritterLogic*>& critters, int cellSize, int towerRangePixels, Vector2 towerPos) = 0;
-    virtual ~TowerTargetingStrategy() = default;
+// Closed set of targeting strategies. Towers store one of these and the update loop
+// switches on it, so each strategy is inlined into its own scan with no virtual call.
+enum class TargetingMode {
+    NEAREST,          // nearest critter to the tower
+    CLOSEST_TO_EXIT,  // critter nearest to the exit
+    WEAKEST,          // least health
+    STRONGEST         // most health
 };
+
+// Each policy scores an in-range critter; the lowest score wins.
+struct NearestTargeting {
+    static SimWide score(const CritterLogic*, SimWide distanceSquared) { return distanceSquared; }
+};
+
+struct ClosestToExitTargeting {
+    static SimWide score(const CritterLogic* critter, SimWide) { return -critter->getProgress(); }
+};
+
+struct WeakestTargeting {
+    static SimWide score(const CritterLogic* critter, SimWide) { return SimWide(critter->getHealth()); }
+};
+
+struct StrongestTargeting {
+    static SimWide score(const CritterLogic* critter, SimWide) { return -SimWide(critter->getHealth()); }
+};
+
+// Scores every live critter the grid reports within range of the tower.
+template <class Policy>
+inline CritterLogic* findTarget(const SpatialGrid& grid, SimScalar towerRangePixels, SimVec2 towerPos) {
+    CritterLogic* target = nullptr;
+    SimWide bestScore = 0;
+    grid.forEachInRadius(towerPos, towerRangePixels, [&](CritterLogic* critter, SimWide distanceSquared) {
+        if (critter->isDead()) {
+            return;
+        }
+        SimWide score = Policy::score(critter, distanceSquared);
+        if (!target || score < bestScore) {
+            target = critter;
+            bestScore = score;
+        }
+    });
+    return target;
+}
+
+inline CritterLogic* selectTarget(TargetingMode mode, const SpatialGrid& grid, SimScalar towerRangePixels, SimVec2 towerPos) {
+    switch (mode) {
+    case TargetingMode::NEAREST:         return findTarget<NearestTargeting>(grid, towerRangePixels, towerPos);
+    case TargetingMode::CLOSEST_TO_EXIT: return findTarget<ClosestToExitTargeting>(grid, towerRangePixels, towerPos);
+    case TargetingMode::WEAKEST:         return findTarget<WeakestTargeting>(grid, towerRangePixels, towerPos);
+    case TargetingMode::STRONGEST:       return findTarget<StrongestTargeting>(grid, towerRangePixels, towerPos);
+    default:                             return nullptr;
+    }
+}
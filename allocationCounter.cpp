@@ -0,0 +1,78 @@
+#include "allocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+#ifdef SIM_COUNT_ALLOCATIONS
+
+// Replacing the global operators here counts every allocation in the program;
+// the counter is per thread so the simulation and render threads do not mix.
+static thread_local std::size_t threadAllocations = 0;
+
+std::size_t getThreadAllocationCount() {
+    return threadAllocations;
+}
+
+static void* countedAllocate(std::size_t bytes) {
+    threadAllocations++;
+    return std::malloc(bytes == 0 ? 1 : bytes);
+}
+
+void* operator new(std::size_t bytes) {
+    void* p = countedAllocate(bytes);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t bytes) {
+    return operator new(bytes);
+}
+
+void* operator new(std::size_t bytes, const std::nothrow_t&) noexcept {
+    return countedAllocate(bytes);
+}
+
+void* operator new[](std::size_t bytes, const std::nothrow_t&) noexcept {
+    return countedAllocate(bytes);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+bool isAllocationCountingBuilt() {
+    return true;
+}
+
+#else
+
+std::size_t getThreadAllocationCount() {
+    return 0;
+}
+
+bool isAllocationCountingBuilt() {
+    return false;
+}
+
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+// Counts every global operator new made by the calling thread, tracked or not.
+// Used to check that steady-state simulation ticks never touch the heap.
+//
+// Counting replaces the global operators, so it is only built in when SIM_COUNT_ALLOCATIONS
+// is among the project's preprocessor definitions; the game otherwise keeps the default
+// allocator and the count stays 0.
+std::size_t getThreadAllocationCount();
+// False if this build does not count, in which case getThreadAllocationCount proves nothing.
+bool isAllocationCountingBuilt();
+
+#endif
@@ -0,0 +1,245 @@
+#include "balanceRunner.h"
+#include "allocationCounter.h"
+#include "memoryArena.h"
+#include "logger.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+
+BalanceRunner::BalanceRunner(MapLogic& mapLogic, const std::vector<TowerPlacement>& layout, const SimulationConfig& config)
+    : mapLogic(mapLogic), layout(layout), config(config) {}
+
+std::vector<SimulationResult> BalanceRunner::run(unsigned int seedBase, int seedCount, int threadCount) {
+    std::vector<SimulationResult> results(seedCount);
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    if (threadCount <= 0) {
+        threadCount = 1;
+    }
+    if (threadCount > seedCount) {
+        threadCount = seedCount;
+    }
+
+    // Build the path once up front so workers only ever read the map.
+    mapLogic.getPath();
+
+    std::atomic<int> nextGame(0);
+    auto worker = [&]() {
+        MemoryArena arena;
+        MemoryTracker::setThreadArena(&arena);
+        for (int game = nextGame++; game < seedCount; game = nextGame++) {
+            GameSimulation simulation(mapLogic, layout, config, seedBase + game);
+            results[game] = simulation.run();
+        }
+        // Every game object is gone by now, so nothing outlives the arena.
+        MemoryTracker::setThreadArena(nullptr);
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threadCount; i++) {
+        workers.emplace_back(worker);
+    }
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+    return results;
+}
+
+void BalanceRunner::writeCsv(std::ostream& out, const std::vector<SimulationResult>& results) {
+    out << "seed,won,survived_waves,leaks,ticks,ticks_per_second,"
+           "damage_basic,damage_splash,damage_slow,damage_sniper\n";
+    for (const SimulationResult& result : results) {
+        out << result.seed << "," << (result.won ? 1 : 0) << "," << result.survivedWaves << ","
+            << result.leaks << "," << result.ticks << ","
+            << static_cast<long long>(result.seconds > 0.0 ? result.ticks / result.seconds : 0.0);
+        for (int i = 0; i < towerTypeCount; i++) {
+            out << "," << result.damageByType[i];
+        }
+        out << "\n";
+    }
+}
+
+static void printBalanceUsage() {
+    std::cerr << "Usage: --balance --map <file> --towers <file> [--waves N] [--lives N]\n"
+                 "                 [--seeds N] [--seed S] [--threads N] [--max-ticks N] [--out file.csv]\n";
+}
+
+bool loadScenario(const std::string& mapFile, const std::string& towerFile,
+                  MapLogic& mapLogic, std::vector<TowerPlacement>& layout) {
+    if (!mapLogic.loadFromFile(mapFile) || (!towerFile.empty() && !loadTowerLayout(towerFile, layout))) {
+        return false;
+    }
+    if (mapLogic.getPath().empty()) {
+        LOG_ERROR("Map {} has no path from entry to exit", mapFile);
+        return false;
+    }
+    for (const TowerPlacement& placement : layout) {
+        if (placement.x < 0 || placement.x >= mapLogic.getWidth() ||
+            placement.y < 0 || placement.y >= mapLogic.getHeight() ||
+            mapLogic.getCell(placement.x, placement.y).type != SCENERY) {
+            LOG_ERROR("Tower at {},{} is not on a scenery cell", placement.x, placement.y);
+            return false;
+        }
+    }
+    return true;
+}
+
+int runBalanceCommand(int argc, char** argv) {
+    std::string mapFile;
+    std::string towerFile;
+    std::string outFile;
+    SimulationConfig config = { 20, 20, 40, 1000000, 0 };
+    int seedCount = 100;
+    unsigned int seedBase = 1;
+    int threadCount = 0;
+
+    for (int i = 0; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            printBalanceUsage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (option == "--map") { mapFile = value; }
+        else if (option == "--towers") { towerFile = value; }
+        else if (option == "--out") { outFile = value; }
+        else if (option == "--waves") { config.maxWaves = std::atoi(value); }
+        else if (option == "--lives") { config.lives = std::atoi(value); }
+        else if (option == "--max-ticks") { config.maxTicks = std::atoll(value); }
+        else if (option == "--seeds") { seedCount = std::atoi(value); }
+        else if (option == "--seed") { seedBase = static_cast<unsigned int>(std::strtoul(value, nullptr, 10)); }
+        else if (option == "--threads") { threadCount = std::atoi(value); }
+        else {
+            printBalanceUsage();
+            return 1;
+        }
+    }
+    if (mapFile.empty() || towerFile.empty() || seedCount <= 0) {
+        printBalanceUsage();
+        return 1;
+    }
+
+    // Per-game chatter (towers added, waves started) would swamp the output.
+    Logger::setLevel(LogLevel::WARN);
+
+    MapLogic mapLogic;
+    std::vector<TowerPlacement> layout;
+    if (!loadScenario(mapFile, towerFile, mapLogic, layout)) {
+        Logger::flush();
+        return 1;
+    }
+
+    BalanceRunner runner(mapLogic, layout, config);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SimulationResult> results = runner.run(seedBase, seedCount, threadCount);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (outFile.empty()) {
+        BalanceRunner::writeCsv(std::cout, results);
+    }
+    else {
+        std::ofstream out(outFile);
+        if (!out) {
+            LOG_ERROR("Cannot write {}", outFile);
+            Logger::flush();
+            return 1;
+        }
+        BalanceRunner::writeCsv(out, results);
+    }
+
+    long long totalTicks = 0;
+    for (const SimulationResult& result : results) {
+        totalTicks += result.ticks;
+    }
+    std::cerr << seedCount << " games, " << totalTicks << " ticks in " << elapsed.count() << " s ("
+              << static_cast<long long>(elapsed.count() > 0.0 ? totalTicks / elapsed.count() : 0.0) << " ticks/s)\n";
+    Logger::flush();
+    return 0;
+}
+
+static void printAllocationCheckUsage() {
+    std::cerr << "Usage: --check-alloc --map <file> --towers <file> [--warmup-waves N] [--waves N] [--seed S]\n";
+}
+
+int runAllocationCheckCommand(int argc, char** argv) {
+    std::string mapFile;
+    std::string towerFile;
+    SimulationConfig config = { 6, 1000000, 40, 1000000, 0 };
+    int warmupWaves = 3;
+    unsigned int seed = 1;
+
+    for (int i = 0; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            printAllocationCheckUsage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (option == "--map") { mapFile = value; }
+        else if (option == "--towers") { towerFile = value; }
+        else if (option == "--waves") { config.maxWaves = std::atoi(value); }
+        else if (option == "--warmup-waves") { warmupWaves = std::atoi(value); }
+        else if (option == "--seed") { seed = static_cast<unsigned int>(std::strtoul(value, nullptr, 10)); }
+        else {
+            printAllocationCheckUsage();
+            return 1;
+        }
+    }
+    if (mapFile.empty() || towerFile.empty() || warmupWaves >= config.maxWaves) {
+        printAllocationCheckUsage();
+        return 1;
+    }
+    if (!isAllocationCountingBuilt()) {
+        LOG_ERROR("--check-alloc needs a build with SIM_COUNT_ALLOCATIONS defined");
+        Logger::flush();
+        return 1;
+    }
+
+    Logger::setLevel(LogLevel::WARN);
+
+    MapLogic mapLogic;
+    std::vector<TowerPlacement> layout;
+    if (!loadScenario(mapFile, towerFile, mapLogic, layout)) {
+        Logger::flush();
+        return 1;
+    }
+    mapLogic.getPath();
+
+    // No arena, like the simulation thread of the game, so this checks what the game runs with.
+    // Lives are effectively unlimited so the game reaches the later waves.
+    long long checkedTicks = 0;
+    long long allocatingTicks = 0;
+    std::size_t allocations = 0;
+    {
+        GameSimulation simulation(mapLogic, layout, config, seed);
+        bool running = true;
+        // Warm-up fills the critter pool and the reserved capacities
+        while (running && simulation.getCurrentWave() <= warmupWaves) {
+            running = simulation.step();
+        }
+        while (running) {
+            int wave = simulation.getCurrentWave();
+            std::size_t before = getThreadAllocationCount();
+            running = simulation.step();
+            std::size_t made = getThreadAllocationCount() - before;
+            // Starting a wave may grow capacities for its larger critter count
+            if (simulation.getCurrentWave() != wave) {
+                continue;
+            }
+            checkedTicks++;
+            if (made > 0) {
+                allocatingTicks++;
+                allocations += made;
+            }
+        }
+    }
+
+    std::cerr << checkedTicks << " steady-state ticks checked, " << allocatingTicks << " allocated ("
+              << allocations << " allocations)\n";
+    Logger::flush();
+    return allocatingTicks == 0 && checkedTicks > 0 ? 0 : 1;
+}
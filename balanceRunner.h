@@ -0,0 +1,41 @@
+#pragma once
+#ifndef BALANCE_RUNNER_H
+#define BALANCE_RUNNER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "gameSimulation.h"
+
+// Plays many seeded games of one map and tower layout in parallel, for tuning tower and critter stats.
+// Workers share the map read-only; each one serves its games' allocations from its own arena.
+class BalanceRunner {
+public:
+    BalanceRunner(MapLogic& mapLogic, const std::vector<TowerPlacement>& layout, const SimulationConfig& config);
+
+    // Runs seeds seedBase .. seedBase + seedCount - 1 on threadCount workers (0 = one per core).
+    // Results come back in seed order whatever the thread count.
+    std::vector<SimulationResult> run(unsigned int seedBase, int seedCount, int threadCount);
+
+    static void writeCsv(std::ostream& out, const std::vector<SimulationResult>& results);
+
+private:
+    MapLogic& mapLogic;
+    const std::vector<TowerPlacement>& layout;
+    SimulationConfig config;
+};
+
+// Loads a map and, unless towerFile is empty, a tower layout, and checks every tower sits on scenery.
+// Logs the problem and returns false if either file is unusable.
+bool loadScenario(const std::string& mapFile, const std::string& towerFile,
+                  MapLogic& mapLogic, std::vector<TowerPlacement>& layout);
+
+// Entry point for "--balance": parses the options that follow it, runs the games and writes CSV.
+// Returns the process exit code.
+int runBalanceCommand(int argc, char** argv);
+
+// Entry point for "--check-alloc": plays one game on the calling thread and fails if any
+// tick after warm-up, other than a wave change, allocates from the heap. Returns the exit code.
+int runAllocationCheckCommand(int argc, char** argv);
+
+#endif
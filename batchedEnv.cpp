@@ -0,0 +1,197 @@
+#include "batchedEnv.h"
+#include "balanceRunner.h"
+#include "logger.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+BatchedEnv::BatchedEnv(MapLogic& mapLogic, const std::vector<TowerPlacement>& layout, const SimulationConfig& config,
+                       int envCount, unsigned int seedBase, int threadCount)
+    : mapLogic(mapLogic), layout(layout), config(config), pool(threadCount) {
+    // Build the path once up front so the envs only ever read the map.
+    mapLogic.getPath();
+    for (int i = 0; i < envCount; i++) {
+        envs.emplace_back(new GameSimulation(mapLogic, layout, config, seedBase + i));
+    }
+}
+
+int BatchedEnv::size() const {
+    return static_cast<int>(envs.size());
+}
+
+void BatchedEnv::step(const SimCommand* actions, int ticksPerStep) {
+    pool.parallelFor(size(), [this, actions, ticksPerStep](int env) {
+        GameSimulation& game = *envs[env];
+        if (game.isOver()) {
+            return;
+        }
+        game.applyCommand(actions[env]);
+        for (int tick = 0; tick < ticksPerStep && game.step(); tick++) {
+        }
+    });
+}
+
+void BatchedEnv::reset(int env, unsigned int seed) {
+    envs[env].reset(new GameSimulation(mapLogic, layout, config, seed));
+}
+
+// Sizes the flat arrays from the per-env counts first, then every env fills its own slice in parallel.
+void BatchedEnv::observe(BatchObservation& observation) {
+    size_t count = envs.size();
+    observation.money.resize(count);
+    observation.wave.resize(count);
+    observation.lives.resize(count);
+    observation.done.resize(count);
+    observation.critterOffset.resize(count + 1);
+    observation.towerOffset.resize(count + 1);
+    observation.critterOffset[0] = 0;
+    observation.towerOffset[0] = 0;
+    for (size_t i = 0; i < count; i++) {
+        observation.critterOffset[i + 1] = observation.critterOffset[i] + static_cast<int>(envs[i]->getCritters().size());
+        observation.towerOffset[i + 1] = observation.towerOffset[i] + static_cast<int>(envs[i]->getTowerManager().getTowers().size());
+    }
+
+    size_t critters = observation.critterOffset[count];
+    observation.critterX.resize(critters);
+    observation.critterY.resize(critters);
+    observation.critterHealth.resize(critters);
+    observation.critterMaxHealth.resize(critters);
+    observation.critterType.resize(critters);
+    size_t towers = observation.towerOffset[count];
+    observation.towerId.resize(towers);
+    observation.towerX.resize(towers);
+    observation.towerY.resize(towers);
+    observation.towerType.resize(towers);
+    observation.towerLevel.resize(towers);
+    observation.towerRange.resize(towers);
+    observation.towerPower.resize(towers);
+    observation.towerRateOfFire.resize(towers);
+
+    int cellSize = config.cellSize;
+    pool.parallelFor(size(), [this, &observation, cellSize](int env) {
+        const GameSimulation& game = *envs[env];
+        observation.money[env] = game.getMoney();
+        observation.wave[env] = game.getCurrentWave();
+        observation.lives[env] = game.getLives();
+        observation.done[env] = game.isOver() ? 1 : 0;
+
+        int index = observation.critterOffset[env];
+        for (const CritterLogic* critter : game.getCritters()) {
+            Vector2 position = toVector2(critter->getPosition(cellSize));
+            observation.critterX[index] = position.x;
+            observation.critterY[index] = position.y;
+            observation.critterHealth[index] = critter->getHealth();
+            observation.critterMaxHealth[index] = critter->getMaxHealth();
+            observation.critterType[index] = critter->getType();
+            index++;
+        }
+
+        const TowerManager& towerManager = game.getTowerManager();
+        const TowerList& towers = towerManager.getTowers();
+        index = observation.towerOffset[env];
+        for (size_t i = 0; i < towers.size(); i++) {
+            const Tower* tower = towers[i];
+            Vector2 position = tower->getPosition();
+            observation.towerId[index] = towerManager.getTowerIdAt(i);
+            observation.towerX[index] = static_cast<int>(position.x) / cellSize;
+            observation.towerY[index] = static_cast<int>(position.y) / cellSize;
+            observation.towerType[index] = static_cast<int>(tower->getTowerType());
+            observation.towerLevel[index] = tower->getLevel();
+            observation.towerRange[index] = tower->getRange();
+            observation.towerPower[index] = tower->getPower();
+            observation.towerRateOfFire[index] = tower->getRateOfFire();
+            index++;
+        }
+    });
+}
+
+static void printEnvBenchUsage() {
+    std::cerr << "Usage: --env-bench --map <file> [--towers <file>] [--envs N] [--steps N] [--ticks-per-step N]\n"
+                 "                   [--threads N] [--seed S] [--money N] [--waves N]\n";
+}
+
+int runEnvBenchCommand(int argc, char** argv) {
+    std::string mapFile;
+    std::string towerFile;
+    SimulationConfig config = { 20, 20, 40, 1000000, 500 };
+    int envCount = 64;
+    int steps = 1000;
+    int ticksPerStep = 1;
+    int threadCount = 0;
+    unsigned int seedBase = 1;
+
+    for (int i = 0; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            printEnvBenchUsage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (option == "--map") { mapFile = value; }
+        else if (option == "--towers") { towerFile = value; }
+        else if (option == "--envs") { envCount = std::atoi(value); }
+        else if (option == "--steps") { steps = std::atoi(value); }
+        else if (option == "--ticks-per-step") { ticksPerStep = std::atoi(value); }
+        else if (option == "--threads") { threadCount = std::atoi(value); }
+        else if (option == "--seed") { seedBase = static_cast<unsigned int>(std::strtoul(value, nullptr, 10)); }
+        else if (option == "--money") { config.startingMoney = std::atoi(value); }
+        else if (option == "--waves") { config.maxWaves = std::atoi(value); }
+        else {
+            printEnvBenchUsage();
+            return 1;
+        }
+    }
+    if (mapFile.empty() || envCount <= 0 || steps <= 0 || ticksPerStep <= 0) {
+        printEnvBenchUsage();
+        return 1;
+    }
+
+    Logger::setLevel(LogLevel::WARN);
+
+    MapLogic mapLogic;
+    std::vector<TowerPlacement> layout;
+    if (!loadScenario(mapFile, towerFile, mapLogic, layout)) {
+        Logger::flush();
+        return 1;
+    }
+
+    BatchedEnv batch(mapLogic, layout, config, envCount, seedBase, threadCount);
+    BatchObservation observation;
+    std::vector<SimCommand> actions(envCount);
+    std::mt19937 rng(seedBase);
+    unsigned int nextSeed = seedBase + envCount;
+    long long resets = 0;
+
+    // A stand-in for an agent: now and then each env tries to buy a random tower on a random cell
+    auto start = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; step++) {
+        for (int env = 0; env < envCount; env++) {
+            SimCommand& action = actions[env];
+            action = { SimCommandType::NONE, TowerType::BASIC, 0, 0, INVALID_TOWER_ID, UpgradeType::POWER };
+            if (rng() % 60 == 0) {
+                action.type = SimCommandType::PLACE_TOWER;
+                action.towerType = static_cast<TowerType>(rng() % towerTypeCount);
+                action.cellX = static_cast<int>(rng() % mapLogic.getWidth());
+                action.cellY = static_cast<int>(rng() % mapLogic.getHeight());
+            }
+        }
+        batch.step(actions.data(), ticksPerStep);
+        batch.observe(observation);
+        for (int env = 0; env < envCount; env++) {
+            if (observation.done[env]) {
+                batch.reset(env, nextSeed++);
+                resets++;
+            }
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    double envSteps = static_cast<double>(steps) * envCount;
+    std::cout << envCount << " envs x " << steps << " steps (" << ticksPerStep << " ticks each) in "
+              << elapsed.count() << " s: " << static_cast<long long>(envSteps / elapsed.count()) << " env steps/s, "
+              << static_cast<long long>(envSteps / elapsed.count() * 3600.0) << " per hour, " << resets << " resets\n";
+    Logger::flush();
+    return 0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef BATCHED_ENV_H
+#define BATCHED_ENV_H
+
+#include <memory>
+#include <vector>
+#include "gameSimulation.h"
+#include "workerPool.h"
+
+// Observations of every env as flat arrays, ready to hand to a training framework without
+// per-env copies. Per-env arrays are indexed by env. Critter and tower arrays hold every env's
+// entries back to back: env i owns [critterOffset[i], critterOffset[i + 1]) and likewise for towers.
+// The vectors keep their capacity, so reusing one observation across steps does not allocate.
+struct BatchObservation {
+    std::vector<int> money;
+    std::vector<int> wave;
+    std::vector<int> lives;
+    std::vector<unsigned char> done;
+
+    std::vector<int> critterOffset;
+    std::vector<float> critterX;  // Pixels
+    std::vector<float> critterY;
+    std::vector<int> critterHealth;
+    std::vector<int> critterMaxHealth;
+    std::vector<int> critterType;  // CritterType
+
+    std::vector<int> towerOffset;
+    std::vector<TowerId> towerId;  // For UPGRADE_TOWER and SELL_TOWER actions
+    std::vector<int> towerX;       // Cell
+    std::vector<int> towerY;
+    std::vector<int> towerType;    // TowerType
+    std::vector<int> towerLevel;
+    std::vector<int> towerRange;   // Cells
+    std::vector<int> towerPower;
+    std::vector<float> towerRateOfFire;
+};
+
+// Many independent games over one shared map, stepped together for training placement agents.
+// The map is only read once the envs exist; each env is a GameSimulation with its own critters,
+// towers, money and RNG. Steps run on a pool of worker threads that lives as long as the batch.
+class BatchedEnv {
+public:
+    // threadCount 0 = one per core. Env i starts with seed seedBase + i.
+    BatchedEnv(MapLogic& mapLogic, const std::vector<TowerPlacement>& layout, const SimulationConfig& config,
+               int envCount, unsigned int seedBase, int threadCount);
+
+    int size() const;
+    // Applies actions[i] to env i, then advances every env that is not over by ticksPerStep ticks.
+    // actions holds one command per env; use SimCommandType::NONE for no action.
+    void step(const SimCommand* actions, int ticksPerStep);
+    // Starts env over as a fresh game with a new seed.
+    void reset(int env, unsigned int seed);
+    // Fills observation with the current state of every env.
+    void observe(BatchObservation& observation);
+
+private:
+    MapLogic& mapLogic;
+    const std::vector<TowerPlacement>& layout;
+    SimulationConfig config;
+    std::vector<std::unique_ptr<GameSimulation>> envs;
+    WorkerPool pool;
+};
+
+// Entry point for "--env-bench": steps a batch of envs with random actions and reports steps per second.
+// Returns the process exit code.
+int runEnvBenchCommand(int argc, char** argv);
+
+#endif
@@ -0,0 +1,152 @@
+#include "coverageMap.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+static bool isPathCell(CellType type) {
+    return type == PATH || type == ENTRY || type == EXIT;
+}
+
+CoverageMap::CoverageMap() : width(0), height(0), chunksAcross(0), mapVersion(0), synced(false) {}
+
+// Widest horizontal offset dx with dx * dx + dy * dy <= range * range.
+int CoverageMap::halfWidth(int range, int dy) {
+    return static_cast<int>(std::sqrt(static_cast<float>(range * range - dy * dy)) + 1e-4f);
+}
+
+void CoverageMap::updateMax(RangeLayer& layer) {
+    layer.maxCount = 0;
+    for (const auto& entry : layer.chunks) {
+        for (int count : entry.second.counts) {
+            layer.maxCount = count > layer.maxCount ? count : layer.maxCount;
+        }
+    }
+}
+
+const CoverageMap::RangeLayer* CoverageMap::findLayer(int range) const {
+    for (const RangeLayer& layer : layers) {
+        if (layer.range == range) {
+            return &layer;
+        }
+    }
+    return nullptr;
+}
+
+void CoverageMap::update(MapLogic& mapLogic, int range) {
+    sync(mapLogic);
+    if (findLayer(range)) {
+        return;
+    }
+    layers.emplace_back();
+    layers.back().range = range;
+    build(layers.back());
+}
+
+int CoverageMap::getCoverage(int range, int x, int y) const {
+    const RangeLayer* layer = findLayer(range);
+    if (!layer || x < 0 || x >= width || y < 0 || y >= height) {
+        return 0;
+    }
+    auto it = layer->chunks.find((y / chunkSize) * chunksAcross + x / chunkSize);
+    if (it == layer->chunks.end()) {
+        return 0;
+    }
+    return it->second.counts[(y % chunkSize) * chunkSize + x % chunkSize];
+}
+
+int CoverageMap::getMaxCoverage(int range) const {
+    const RangeLayer* layer = findLayer(range);
+    return layer ? layer->maxCount : 0;
+}
+
+void CoverageMap::sync(MapLogic& mapLogic) {
+    if (synced && mapLogic.getVersion() == mapVersion &&
+        mapLogic.getWidth() == width && mapLogic.getHeight() == height) {
+        return;
+    }
+    bool resized = mapLogic.getWidth() != width || mapLogic.getHeight() != height;
+    width = mapLogic.getWidth();
+    height = mapLogic.getHeight();
+    chunksAcross = (width + chunkSize - 1) / chunkSize;
+    mapVersion = mapLogic.getVersion();
+    synced = true;
+
+    // Uniform chunks are taken whole; only chunks with mixed cells are read cell by cell
+    CoverageCellList cells;
+    mapLogic.forEachChunk([&](const MapChunkView& chunk) {
+        if (chunk.uniform && !isPathCell(chunk.type)) {
+            return;
+        }
+        for (int y = chunk.y; y < chunk.y + chunk.height; y++) {
+            for (int x = chunk.x; x < chunk.x + chunk.width; x++) {
+                if (chunk.uniform || isPathCell(mapLogic.getCellType(x, y))) {
+                    cells.push_back(y * width + x);
+                }
+            }
+        }
+    });
+    std::sort(cells.begin(), cells.end());
+
+    if (resized) {
+        pathCells.swap(cells);
+        for (RangeLayer& layer : layers) {
+            build(layer);
+        }
+        return;
+    }
+
+    CoverageCellList added;
+    CoverageCellList removed;
+    std::set_difference(cells.begin(), cells.end(), pathCells.begin(), pathCells.end(), std::back_inserter(added));
+    std::set_difference(pathCells.begin(), pathCells.end(), cells.begin(), cells.end(), std::back_inserter(removed));
+    pathCells.swap(cells);
+    if (added.empty() && removed.empty()) {
+        return;
+    }
+    for (RangeLayer& layer : layers) {
+        // Both cost one disc per cell: patching per changed cell, a rebuild per path cell
+        if (added.size() + removed.size() >= pathCells.size()) {
+            build(layer);
+            continue;
+        }
+        for (int cell : added) {
+            applyDisc(layer, cell % width, cell / width, 1);
+        }
+        for (int cell : removed) {
+            applyDisc(layer, cell % width, cell / width, -1);
+        }
+        updateMax(layer);
+    }
+}
+
+void CoverageMap::build(RangeLayer& layer) const {
+    layer.chunks.clear();
+    for (int cell : pathCells) {
+        applyDisc(layer, cell % width, cell / width, 1);
+    }
+    updateMax(layer);
+}
+
+void CoverageMap::applyDisc(RangeLayer& layer, int cx, int cy, int delta) const {
+    int range = layer.range;
+    for (int dy = -range; dy <= range; dy++) {
+        int y = cy + dy;
+        if (y < 0 || y >= height) {
+            continue;
+        }
+        int half = halfWidth(range, dy);
+        int left = cx - half < 0 ? 0 : cx - half;
+        int right = cx + half >= width ? width - 1 : cx + half;
+        // One chunk lookup per chunk the row crosses; new chunks start at zero
+        int chunkRow = (y / chunkSize) * chunksAcross;
+        int* row = nullptr;
+        int rowStart = 0;
+        for (int x = left; x <= right; x++) {
+            if (!row || x - rowStart >= chunkSize) {
+                rowStart = x - x % chunkSize;
+                row = &layer.chunks[chunkRow + x / chunkSize].counts[(y % chunkSize) * chunkSize];
+            }
+            row[x - rowStart] += delta;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef COVERAGE_MAP_H
+#define COVERAGE_MAP_H
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "mapLogic.h"
+#include "memoryTracker.h"
+
+typedef std::vector<int, TrackedAllocator<int, MemorySubsystem::UI>> CoverageCellList;
+
+// For every cell, how many path cells a tower standing there would reach.
+// A tower of range r reaches the cells whose centres lie within r cells of its own,
+// the same circle it targets with (range * cellSize pixels).
+//
+// Counts are kept in chunks laid out like MapLogic's, and only for chunks within range of
+// the path, so memory follows the path rather than the map. Each path cell adds its disc of
+// reach once. After a map edit only the discs of the changed path cells are patched,
+// unless so much changed that starting over is cheaper.
+class CoverageMap {
+public:
+    CoverageMap();
+
+    // Brings the counts for towers of this range up to date with the map.
+    void update(MapLogic& mapLogic, int range);
+    // Path cells a tower of this range at (x, y) would reach, as of the last update; 0 off the map.
+    int getCoverage(int range, int x, int y) const;
+    // Highest count for this range, as of the last update.
+    int getMaxCoverage(int range) const;
+
+private:
+    static const int chunkSize = MapLogic::chunkSize;
+
+    struct CoverageChunk {
+        int counts[chunkSize * chunkSize];
+    };
+    typedef std::unordered_map<int, CoverageChunk, std::hash<int>, std::equal_to<int>,
+        TrackedAllocator<std::pair<const int, CoverageChunk>, MemorySubsystem::UI>> CoverageChunks;
+
+    struct RangeLayer {
+        int range;
+        int maxCount;
+        CoverageChunks chunks;  // By chunkY * chunksAcross + chunkX; missing chunks count 0
+    };
+
+    int width;
+    int height;
+    int chunksAcross;
+    unsigned int mapVersion;
+    bool synced;
+    CoverageCellList pathCells;     // y * width + x of every cell critters walk, ascending
+    std::vector<RangeLayer> layers; // Every range asked for so far
+
+    void sync(MapLogic& mapLogic);
+    void build(RangeLayer& layer) const;
+    // Adds delta to every cell within the layer's range of (cx, cy).
+    void applyDisc(RangeLayer& layer, int cx, int cy, int delta) const;
+    const RangeLayer* findLayer(int range) const;
+    static int halfWidth(int range, int dy);
+    static void updateMax(RangeLayer& layer);
+};
+
+#endif
@@ -1,57 +1,36 @@
 #include "critterLogic.h"
 #include "CritterFactory.h"
+#include "logger.h"
+#include "textCache.h"
+#include "workerPool.h"
 #include <memory>
+#include <algorithm>
 
 //Superclass
 //creates a critter based on type
-CritterLogic::CritterLogic(MapLogic& mapLogic, int level) : mapLogic(mapLogic), level(level), x(mapLogic.getEntryX()), y(mapLogic.getEntryY()), lastX(-1), lastY(-1), frameCounter(0) {}
+CritterLogic::CritterLogic(MapLogic& mapLogic, int level) : id(-1), mapLogic(mapLogic), path(&mapLogic.getPath()), level(level), x(mapLogic.getEntryX()), y(mapLogic.getEntryY()), progress(0), previousProgress(0), effects(), swarmDamage(0) {
+    effects.slowPercent = 100;
+}
 
+// Advances the critter along the precomputed path by one tick's worth of distance.
 void CritterLogic::move() {
-    std::vector<std::vector<Cell>> map = mapLogic.getMap();
-    std::vector<std::pair<int, int>> possibleMoves;
-
-    if (frameCounter < moveInterval) {
-        frameCounter++;  // Increase frame counter
-        return;  // Skip movement if not time to move yet
-    }
-
-    frameCounter = 0;  // Reset counter after movement
-
-    // Ensure x and y are within bounds before accessing map[y][x]
-    if (y >= 0 && y < map.size() && x + 1 >= 0 && x + 1 < map[0].size() &&
-        (map[y][x + 1].type == CellType::PATH || map[y][x + 1].type == CellType::EXIT) && (x + 1 != lastX || y != lastY)) {
-        possibleMoves.emplace_back(x + 1, y);
-    }
-    if (y + 1 >= 0 && y + 1 < map.size() && x >= 0 && x < map[0].size() &&
-        (map[y + 1][x].type == CellType::PATH || map[y + 1][x].type == CellType::EXIT) && (x != lastX || y + 1 != lastY)) {
-        possibleMoves.emplace_back(x, y + 1);
+    previousProgress = progress;
+    if (path->size() < 2) {
+        return;
     }
-    if (y >= 0 && y < map.size() && x - 1 >= 0 && x - 1 < map[0].size() &&
-        (map[y][x - 1].type == CellType::PATH || map[y][x - 1].type == CellType::EXIT) && (x - 1 != lastX || y != lastY)) {
-        possibleMoves.emplace_back(x - 1, y);
-    }
-    if (y - 1 >= 0 && y - 1 < map.size() && x >= 0 && x < map[0].size() &&
-        (map[y - 1][x].type == CellType::PATH || map[y - 1][x].type == CellType::EXIT) && (x != lastX || y - 1 != lastY)) {
-        possibleMoves.emplace_back(x, y - 1);
-    }
-
 
-    if (!possibleMoves.empty()) {
-        std::srand(std::time(0));
-        std::pair<int, int> chosenMove = possibleMoves[std::rand() % possibleMoves.size()];
-        int newX = chosenMove.first;
-        int newY = chosenMove.second;
-
-        lastX = x;
-        lastY = y;
-        x = newX;
-        y = newY;
-    }
+    SimScalar speed = getSpeed();
+    SimScalar end = simFromInt(static_cast<int>(path->size() - 1));
+    progress = progress + speed < end ? progress + speed : end;
 
+    const PathPoint& cell = (*path)[static_cast<size_t>(getPathIndex())];
+    x = cell.x;
+    y = cell.y;
 }
 
 void CritterLogic::takeDamage(int damage) {
     hit_points -= damage;
+    promoteSwarmMember();
 }
 
 bool CritterLogic::isDead() const {
@@ -64,15 +43,173 @@ void CritterLogic::Update() {
 
 int CritterLogic::getHealth() const { return hit_points; }
 int CritterLogic::getMaxHealth() const { return maxHealth; }
-void CritterLogic::minusHealth(int minusHealth) { hit_points -= minusHealth; }
+int CritterLogic::minusHealth(int minusHealth) {
+    int overkill = hit_points > 0 && minusHealth > hit_points ? minusHealth - hit_points : 0;
+    hit_points -= minusHealth;
+    promoteSwarmMember();
+    return overkill;
+}
 int CritterLogic::getX() const { return x; }
 int CritterLogic::getY() const { return y; }
 int CritterLogic::getDistanceToExit() const {
-    int exitX = mapLogic.getExitX();
-    int exitY = mapLogic.getExitY();
-    return std::abs(x - exitX) + std::abs(y - exitY);
+    if (path->empty()) {
+        return std::abs(x - mapLogic.getExitX()) + std::abs(y - mapLogic.getExitY());
+    }
+    return simToInt(simFromInt(static_cast<int>(path->size() - 1)) - progress + simRatio(999, 1000));
+}
+SimScalar CritterLogic::getProgress() const { return progress; }
+int CritterLogic::getId() const { return id; }
+void CritterLogic::setId(int newId) { id = newId; }
+
+// moveInterval is the number of frames to cross one cell; slows scale the speed down
+SimScalar CritterLogic::getSpeed() const {
+    SimScalar speed = simRatio(1, moveInterval);
+    if (effects.slowTicks > 0) {
+        speed = speed * effects.slowPercent / 100;
+    }
+    return speed;
+}
+
+SimVec2 CritterLogic::predictPosition(SimScalar ticks, int cellSize) const {
+    return positionAt(progress + getSpeed() * ticks, cellSize);
+}
+bool CritterLogic::hasReachedExit() const {
+    return path->size() >= 2 && progress >= simFromInt(static_cast<int>(path->size() - 1));
+}
+
+void CritterLogic::placeAt(SimScalar pathProgress) {
+    if (path->empty()) {
+        return;
+    }
+    SimScalar end = simFromInt(static_cast<int>(path->size() - 1));
+    progress = previousProgress = pathProgress < end ? pathProgress : end;
+    const PathPoint& cell = (*path)[static_cast<size_t>(getPathIndex())];
+    x = cell.x;
+    y = cell.y;
+}
+
+SimVec2 CritterLogic::positionAt(SimScalar pathProgress, int cellSize) const {
+    SimScalar half = simRatio(1, 2);
+    if (path->empty()) {
+        return { (simFromInt(x) + half) * cellSize, (simFromInt(y) + half) * cellSize };
+    }
+    int segment = simToInt(pathProgress);
+    if (static_cast<size_t>(segment) + 1 >= path->size()) {
+        const PathPoint& last = path->back();
+        return { (simFromInt(last.x) + half) * cellSize, (simFromInt(last.y) + half) * cellSize };
+    }
+    SimScalar t = pathProgress - simFromInt(segment);
+    const PathPoint& from = (*path)[segment];
+    const PathPoint& to = (*path)[segment + 1];
+    return {
+        (simFromInt(from.x) + t * (to.x - from.x) + half) * cellSize,
+        (simFromInt(from.y) + t * (to.y - from.y) + half) * cellSize
+    };
+}
+
+SimVec2 CritterLogic::getPosition(int cellSize) const {
+    return positionAt(progress, cellSize);
+}
+
+Vector2 CritterLogic::getRenderPosition(int cellSize, float alpha) const {
+    return toVector2(positionAt(previousProgress + (progress - previousProgress) * simFromFloat(alpha), cellSize));
 }
 CritterType CritterLogic::getType() const { return critterType; }
+
+void CritterLogic::applySlow(int percent, int ticks) {
+    if (effects.slowTicks == 0 || percent < effects.slowPercent) {
+        effects.slowPercent = (uint8_t)percent;
+    }
+    if (ticks > effects.slowTicks) {
+        effects.slowTicks = (uint16_t)ticks;
+    }
+}
+
+void CritterLogic::applyDamageOverTime(int damagePerTick, int ticks) {
+    if (effects.dotTicks == 0 || damagePerTick > effects.dotDamage) {
+        effects.dotDamage = (uint16_t)damagePerTick;
+    }
+    if (ticks > effects.dotTicks) {
+        effects.dotTicks = (uint16_t)ticks;
+    }
+}
+
+void CritterLogic::tickStatusEffects() {
+    if (effects.slowTicks > 0 && --effects.slowTicks == 0) {
+        effects.slowPercent = 100;
+    }
+    if (effects.dotTicks > 0) {
+        if (++effects.dotCounter >= DOT_INTERVAL) {
+            effects.dotCounter = 0;
+            takeAreaDamage(effects.dotDamage);
+        }
+        if (--effects.dotTicks == 0) {
+            effects.dotDamage = 0;
+            effects.dotCounter = 0;
+        }
+    }
+}
+
+bool CritterLogic::hasStatusEffects() const { return (effects.slowTicks | effects.dotTicks) != 0; }
+const StatusEffects& CritterLogic::getStatusEffects() const { return effects; }
+
+int CritterLogic::getSwarmSize() const {
+    return isDead() ? 0 : 1 + static_cast<int>(swarmHealth.size());
+}
+
+// Every member loses the same amount, so the order is kept and only the weakest can die.
+int CritterLogic::takeAreaDamage(int damage, long long* overkill) {
+    int members = getSwarmSize();
+    if (overkill && hit_points > 0 && damage > hit_points) {
+        *overkill += damage - hit_points;
+    }
+    hit_points -= damage;
+    swarmDamage += damage;
+    while (!swarmHealth.empty() && swarmHealth.back() - swarmDamage <= 0) {
+        if (overkill) {
+            *overkill += swarmDamage - swarmHealth.back();
+        }
+        swarmHealth.pop_back();
+    }
+    promoteSwarmMember();
+    return damage * members;
+}
+
+// A hit kills at most one member; its overkill does not carry over to the next.
+void CritterLogic::promoteSwarmMember() {
+    while (hit_points <= 0 && !swarmHealth.empty()) {
+        hit_points = swarmHealth.back() - swarmDamage;
+        swarmHealth.pop_back();
+    }
+}
+
+bool CritterLogic::canJoinSwarm(const CritterLogic& other) const {
+    return critterType == other.critterType && level == other.level && !isDead() && !other.isDead() &&
+        !hasStatusEffects() && !other.hasStatusEffects() && getPathIndex() == other.getPathIndex();
+}
+
+void CritterLogic::absorb(CritterLogic& other) {
+    // Bring both swarms to current health, then sort so the weakest becomes the lead
+    for (int& health : swarmHealth) {
+        health -= swarmDamage;
+    }
+    swarmDamage = 0;
+    swarmHealth.push_back(hit_points);
+    swarmHealth.push_back(other.hit_points);
+    for (int health : other.swarmHealth) {
+        swarmHealth.push_back(health - other.swarmDamage);
+    }
+    std::sort(swarmHealth.begin(), swarmHealth.end(), [](int a, int b) { return a > b; });
+    hit_points = swarmHealth.back();
+    swarmHealth.pop_back();
+
+    other.swarmHealth.clear();
+    other.hit_points = 0;
+}
+
+int CritterLogic::getPathIndex() const {
+    return simToInt(progress + simRatio(1, 2));
+}
 std::string CritterLogic::critterTypeToString(CritterType type) {
     switch (type) {
         case CritterType::TANKY: return "Tanky";
@@ -83,19 +220,15 @@ std::string CritterLogic::critterTypeToString(CritterType type) {
     }
 }
 
-//Speedy
-SpeedyCritter::SpeedyCritter(MapLogic& mapLogic, int level) : CritterLogic::CritterLogic(mapLogic, level)
-{
-    critterType = SPEEDY;
-    hit_points = maxHealth = 30 + (level * 5);
-    strength = 4 + (level * 2);
-    reward = 10 + (level * 4);
-    moveInterval = 30;
-}
-void SpeedyCritter::render(Vector2 position) {
+// Draws a critter from plain values, so the render thread can draw snapshots without touching live critters
+void drawCritter(CritterType type, Vector2 position, float healthFraction, int swarmSize) {
     Color critterColor;
-
-    critterColor = MAGENTA;
+    switch (type) {
+    case SPEEDY: critterColor = MAGENTA; break;
+    case TANKY:  critterColor = ORANGE; break;
+    case STRONG: critterColor = DARKPURPLE; break;
+    default:     critterColor = BLACK; break;
+    }
 
     Vector2 v1 = { position.x, position.y - 10 - (10.0f / 3.0f) }; // position.y - 40/3
     Vector2 v2 = { position.x - 10, position.y + 10 - (10.0f / 3.0f) }; // position.y + 20/3
@@ -105,13 +238,32 @@ void SpeedyCritter::render(Vector2 position) {
 
     // Draw Health Bar
     float healthBarWidth = 20.0f; // Max width of health bar
-    float healthPercentage = (float)getHealth() / getMaxHealth();
-    float barWidth = healthBarWidth * healthPercentage; // Scale based on health
+    float barWidth = healthBarWidth * healthFraction; // Scale based on health
 
     Vector2 healthBarPos = { position.x - (healthBarWidth / 2), position.y - 10 }; // Above critter
 
     DrawRectangle(healthBarPos.x, healthBarPos.y, barWidth, 4, GREEN);            // Health amount
     DrawRectangleLines(healthBarPos.x, healthBarPos.y, healthBarWidth, 4, BLACK); // Border
+
+    // One glyph stands for the whole swarm; the badge says how many it holds
+    if (swarmSize > 1) {
+        const TextLayout& count = uiTextCache().number(swarmSize, 10);
+        DrawRectangle(position.x + 6, position.y - 18, count.width + 4, 11, critterColor);
+        DrawText(count.text.c_str(), position.x + 8, position.y - 17, 10, WHITE);
+    }
+}
+
+//Speedy
+SpeedyCritter::SpeedyCritter(MapLogic& mapLogic, int level) : CritterLogic::CritterLogic(mapLogic, level)
+{
+    critterType = SPEEDY;
+    hit_points = maxHealth = 30 + (level * 5);
+    strength = 4 + (level * 2);
+    reward = 10 + (level * 4);
+    moveInterval = 30;
+}
+void SpeedyCritter::render(Vector2 position) {
+    drawCritter(critterType, position, (float)getHealth() / getMaxHealth(), getSwarmSize());
 }
 
 //Tanky
@@ -123,25 +275,7 @@ TankyCritter::TankyCritter(MapLogic& mapLogic, int level) : CritterLogic::Critte
     moveInterval = 90;
 }
 void TankyCritter::render(Vector2 position) {
-    Color critterColor;
-
-    critterColor = ORANGE;
-
-    Vector2 v1 = { position.x, position.y - 10 - (10.0f / 3.0f) }; // position.y - 40/3
-    Vector2 v2 = { position.x - 10, position.y + 10 - (10.0f / 3.0f) }; // position.y + 20/3
-    Vector2 v3 = { position.x + 10, position.y + 10 - (10.0f / 3.0f) }; // position.y + 20/3
-
-    DrawTriangle(v1, v2, v3, critterColor);
-
-    // Draw Health Bar
-    float healthBarWidth = 20.0f; // Max width of health bar
-    float healthPercentage = (float)getHealth() / getMaxHealth();
-    float barWidth = healthBarWidth * healthPercentage; // Scale based on health
-
-    Vector2 healthBarPos = { position.x - (healthBarWidth / 2), position.y - 10 }; // Above critter
-
-    DrawRectangle(healthBarPos.x, healthBarPos.y, barWidth, 4, GREEN);            // Health amount
-    DrawRectangleLines(healthBarPos.x, healthBarPos.y, healthBarWidth, 4, BLACK); // Border
+    drawCritter(critterType, position, (float)getHealth() / getMaxHealth(), getSwarmSize());
 }
 
 //Strong
@@ -153,25 +287,7 @@ StrongCritter::StrongCritter(MapLogic& mapLogic, int level) : CritterLogic::Crit
     moveInterval = 60;
 }
 void StrongCritter::render(Vector2 position) {
-    Color critterColor;
-
-    critterColor = DARKPURPLE;
-
-    Vector2 v1 = { position.x, position.y - 10 - (10.0f / 3.0f) }; // position.y - 40/3
-    Vector2 v2 = { position.x - 10, position.y + 10 - (10.0f / 3.0f) }; // position.y + 20/3
-    Vector2 v3 = { position.x + 10, position.y + 10 - (10.0f / 3.0f) }; // position.y + 20/3
-
-    DrawTriangle(v1, v2, v3, critterColor);
-
-    // Draw Health Bar
-    float healthBarWidth = 20.0f; // Max width of health bar
-    float healthPercentage = (float)getHealth() / getMaxHealth();
-    float barWidth = healthBarWidth * healthPercentage; // Scale based on health
-
-    Vector2 healthBarPos = { position.x - (healthBarWidth / 2), position.y - 10 }; // Above critter
-
-    DrawRectangle(healthBarPos.x, healthBarPos.y, barWidth, 4, GREEN);            // Health amount
-    DrawRectangleLines(healthBarPos.x, healthBarPos.y, healthBarWidth, 4, BLACK); // Border
+    drawCritter(critterType, position, (float)getHealth() / getMaxHealth(), getSwarmSize());
 }
 
 //Balanced
@@ -183,47 +299,98 @@ BasicCritter::BasicCritter(MapLogic& mapLogic, int level) : CritterLogic::Critte
     moveInterval = 40;
 }
 void BasicCritter::render(Vector2 position) {
-    Color critterColor;
-
-    critterColor = BLACK;
-
-    Vector2 v1 = { position.x, position.y - 10 - (10.0f / 3.0f) }; // position.y - 40/3
-    Vector2 v2 = { position.x - 10, position.y + 10 - (10.0f / 3.0f) }; // position.y + 20/3
-    Vector2 v3 = { position.x + 10, position.y + 10 - (10.0f / 3.0f) }; // position.y + 20/3
-
-    DrawTriangle(v1, v2, v3, critterColor);
-
-    // Draw Health Bar
-    float healthBarWidth = 20.0f; // Max width of health bar
-    float healthPercentage = (float) getHealth() / getMaxHealth();
-    float barWidth = healthBarWidth * healthPercentage; // Scale based on health
-
-    Vector2 healthBarPos = { position.x - (healthBarWidth / 2), position.y - 10 }; // Above critter
-
-    DrawRectangle(healthBarPos.x, healthBarPos.y, barWidth, 4, GREEN);            // Health amount
-    DrawRectangleLines(healthBarPos.x, healthBarPos.y, healthBarWidth, 4, BLACK); // Border
+    drawCritter(critterType, position, (float)getHealth() / getMaxHealth(), getSwarmSize());
 }
 
 //Critter Manager Modified
-CritterManager::CritterManager() {}
-CritterManager::~CritterManager() {}
+CritterManager::CritterManager() : rng(static_cast<unsigned int>(std::rand())) {
+    reserveForWave();
+}
+
+CritterManager::CritterManager(unsigned int seed) : rng(seed) {
+    reserveForWave();
+}
+CritterManager::~CritterManager() {
+    resetWave();
+    for (void* storage : spareCritters) {
+        MemoryTracker::deallocate(MemorySubsystem::CRITTERS, storage, sizeof(CritterLogic));
+    }
+}
 
 void CritterManager::addCritter(CritterLogic* critter) {
+    critter->setId(nextCritterId++);
     critters.push_back(critter);
 }
 
+CritterLogic* CritterManager::spawnCritter(CritterType type, MapLogic& mapLogic, int level) {
+    void* storage;
+    if (spareCritters.empty()) {
+        storage = MemoryTracker::allocate(MemorySubsystem::CRITTERS, sizeof(CritterLogic));
+    }
+    else {
+        storage = spareCritters.back();
+        spareCritters.pop_back();
+    }
+    CritterLogic* critter = CritterFactory::createCritter(type, mapLogic, level, storage);
+    if (!critter) {
+        spareCritters.push_back(storage);
+        return nullptr;
+    }
+    addCritter(critter);
+    return critter;
+}
+
+// Ends the critter's life but keeps its storage. Heap critters from CritterFactory are the
+// same size, so they are pooled too.
+void CritterManager::destroyCritter(CritterLogic* critter) {
+    critter->~CritterLogic();
+    spareCritters.push_back(critter);
+}
+
 void CritterManager::removeCritter(CritterLogic* critter) {
     auto it = std::find(critters.begin(), critters.end(), critter);
     if (it != critters.end()) {
-        delete* it;
+        destroyCritter(*it);
         critters.erase(it); 
     }
 }
 
+void CritterManager::removeDeadCritters() {
+    size_t alive = 0;
+    for (size_t i = 0; i < critters.size(); i++) {
+        if (critters[i]->isDead()) {
+            destroyCritter(critters[i]);
+        }
+        else {
+            critters[alive++] = critters[i];
+        }
+    }
+    critters.resize(alive);
+}
+
+int CritterManager::removeCrittersAtExit() {
+    size_t kept = 0;
+    int leaked = 0;
+    for (size_t i = 0; i < critters.size(); i++) {
+        if (critters[i]->hasReachedExit()) {
+            leaked += critters[i]->getSwarmSize();
+            destroyCritter(critters[i]);
+        }
+        else {
+            critters[kept++] = critters[i];
+        }
+    }
+    critters.resize(kept);
+    return leaked;
+}
+
 void CritterManager::update(MapLogic& mapLogic) {
+    mapWidth = mapLogic.getWidth();
+    mapHeight = mapLogic.getHeight();
+    pathOccupancy.sync(mapLogic);
     if (crittersSpawned < totalCritters) {
         if (spawnFrameCounter >= spawnInterval) {
-            addCritter(CritterFactory::createCritter(static_cast<CritterType>(rand() % 4), mapLogic, currentWave));
+            spawnCritter(static_cast<CritterType>(rng() % 4), mapLogic, currentWave);
             crittersSpawned++;
             spawnFrameCounter = 0;
         }
@@ -231,8 +398,37 @@ void CritterManager::update(MapLogic& mapLogic) {
             spawnFrameCounter++;
         }
     }
+    // Expire and apply status effects for the whole wave in one pass
+    bool anyDied = false;
     for (auto& critter : critters) {
-        critter->Update();
+        if (critter->hasStatusEffects()) {
+            critter->tickStatusEffects();
+            anyDied |= critter->isDead();
+        }
+    }
+    if (anyDied) {
+        removeDeadCritters();
+    }
+
+    // Below a few chunks the hand-off costs more than the moves
+    const int moveChunkSize = 2048;
+    int moveChunks = static_cast<int>((critters.size() + moveChunkSize - 1) / moveChunkSize);
+    if (workerPool && moveChunks >= 4) {
+        workerPool->parallelFor(moveChunks, [this, moveChunkSize](int chunk) {
+            size_t begin = static_cast<size_t>(chunk) * moveChunkSize;
+            size_t end = std::min(begin + moveChunkSize, critters.size());
+            for (size_t i = begin; i < end; i++) {
+                critters[i]->Update();
+            }
+        });
+    }
+    else {
+        for (auto& critter : critters) {
+            critter->Update();
+        }
+    }
+    if (swarmAggregation) {
+        mergeSwarms(mapLogic.getPath());
     }
 
     if (critters.empty() && crittersSpawned >= totalCritters) {
@@ -241,17 +437,32 @@ void CritterManager::update(MapLogic& mapLogic) {
 }
 
 void CritterManager::startNextWave() {
-    std::cout << "New wave started" << currentWave;
+    LOG_INFO("New wave started {}", currentWave);
     currentWave++;
+    if (waveMemoryRecording) {
+        MemoryTracker::beginWave(currentWave);
+    }
     crittersSpawned = 0;
     totalCritters = 5 + (currentWave * 2);  // Increase critter count each wave
     spawnFrameCounter = 0;
+    reserveForWave();
+}
+
+// Sizes the per-wave containers once, at the wave boundary, so spawning never grows them mid-wave.
+void CritterManager::reserveForWave() {
+    critters.reserve(totalCritters);
+    spatialGrid.reserve(totalCritters);
+    // Storage for the whole wave up front, so none of its spawns allocates
+    spareCritters.reserve(totalCritters);
+    while (critters.size() + spareCritters.size() < static_cast<size_t>(totalCritters)) {
+        spareCritters.push_back(MemoryTracker::allocate(MemorySubsystem::CRITTERS, sizeof(CritterLogic)));
+    }
 }
 
 
 void CritterManager::resetWave() {
     for (CritterLogic* critter : critters) {
-        delete critter;  // Free memory
+        destroyCritter(critter);
     }
     critters.clear();
     crittersSpawned = 0;
@@ -260,5 +471,73 @@ void CritterManager::resetWave() {
 
 int CritterManager::getCurrentWave() const { return currentWave; }
 int CritterManager::getCrittersSpawned() const { return crittersSpawned; }
-std::vector<CritterLogic*>& CritterManager::getCritters() { return critters; }
+CritterList& CritterManager::getCritters() { return critters; }
+const CritterList& CritterManager::getCritters() const { return critters; }
+
+// Critters are appended in id order and every removal keeps the order,
+// so the list stays sorted by id and a binary search finds the handle.
+CritterLogic* CritterManager::findCritter(int id) const {
+    auto it = std::lower_bound(critters.begin(), critters.end(), id,
+        [](const CritterLogic* critter, int value) { return critter->getId() < value; });
+    if (it == critters.end() || (*it)->getId() != id || (*it)->isDead()) {
+        return nullptr;
+    }
+    return *it;
+}
+
+void CritterManager::rebuildSpatialGrid(int cellSize) {
+    spatialGrid.rebuild(critters, mapWidth, mapHeight, cellSize);
+    pathOccupancy.rebuild(critters);
+}
+
+const SpatialGrid& CritterManager::getSpatialGrid() const { return spatialGrid; }
+const PathOccupancy& CritterManager::getPathOccupancy() const { return pathOccupancy; }
+
+void CritterManager::setSwarmAggregation(bool enabled) { swarmAggregation = enabled; }
+void CritterManager::setWorkerPool(WorkerPool* pool) { workerPool = pool; }
+bool CritterManager::getSwarmAggregation() const { return swarmAggregation; }
+void CritterManager::setWaveMemoryRecording(bool enabled) { waveMemoryRecording = enabled; }
+
+int CritterManager::getMemberCount() const {
+    int members = 0;
+    for (const CritterLogic* critter : critters) {
+        members += critter->getSwarmSize();
+    }
+    return members;
+}
+
+// One pass in id order: the first critter of a type on a path cell leads, later ones merge into it.
+// The lead table is stamped per pass instead of cleared, so merging costs nothing per cell.
+void CritterManager::mergeSwarms(const PathList& path) {
+    size_t slots = path.size() * 4;
+    if (swarmLeads.size() != slots) {
+        swarmLeads.assign(slots, 0);
+        swarmLeadPass.assign(slots, 0);
+    }
+    swarmPass++;
+
+    bool merged = false;
+    for (size_t i = 0; i < critters.size(); i++) {
+        CritterLogic* critter = critters[i];
+        int cell = critter->getPathIndex();
+        if (critter->hasStatusEffects() || critter->isDead() || cell < 0 || static_cast<size_t>(cell) >= path.size()) {
+            continue;
+        }
+        size_t slot = static_cast<size_t>(cell) * 4 + critter->getType();
+        if (swarmLeadPass[slot] == swarmPass) {
+            CritterLogic* lead = critters[swarmLeads[slot]];
+            if (lead->canJoinSwarm(*critter)) {
+                lead->absorb(*critter);
+                merged = true;
+                continue;
+            }
+        }
+        swarmLeads[slot] = static_cast<int>(i);
+        swarmLeadPass[slot] = swarmPass;
+    }
+    // Absorbed critters are left with no health, so the usual sweep deletes them
+    if (merged) {
+        removeDeadCritters();
+    }
+}
 
@@ -7,11 +7,19 @@
 #include <ctime>
 #include <iostream>
 #include <memory>
+#include <cstdint>
+#include <random>
 #include "raylib.h"
 #include "ObservableVec.h"
 #include "ObserverVec.h"
+#include "memoryTracker.h"
+#include "simScalar.h"
 
 #include "mapLogic.h"
+#include "spatialGrid.h"
+#include "pathOccupancy.h"
+
+class WorkerPool;
 
 enum CritterType
 {
@@ -21,8 +29,24 @@ enum CritterType
     BALANCED
 };
 
+// Status effects active on one critter, packed into 8 bytes.
+// A timer of 0 means the effect is not active.
+struct StatusEffects {
+    uint16_t slowTicks;    // Frames of slow left
+    uint8_t slowPercent;   // Movement speed while slowed, in percent of normal
+    uint8_t dotCounter;    // Frames since the last damage-over-time tick
+    uint16_t dotTicks;     // Frames of damage-over-time left
+    uint16_t dotDamage;    // Damage dealt every DOT_INTERVAL frames
+};
+
+// Frames between two damage-over-time ticks
+const int DOT_INTERVAL = 30;
+
+// Radius of a critter's body in pixels (the drawn triangle is 20px wide), used for bullet hits
+const float CRITTER_HIT_RADIUS = 10.0f;
+
 //Critter Superclass
-class CritterLogic : public ObserverVec {
+class CritterLogic : public ObserverVec, public TrackedObject<MemorySubsystem::CRITTERS> {
 public:
     CritterLogic(MapLogic& mapLogic, int level);
     virtual ~CritterLogic() = default;
@@ -36,26 +60,80 @@ public:
 
     int getHealth() const;
     int getMaxHealth() const;
-    void minusHealth(int minusHealth);
+    // Returns the overkill: how much of the damage went past the last hit point.
+    int minusHealth(int minusHealth);
     int getX() const;
     int getY() const;
     int getDistanceToExit() const;
     CritterType getType() const;
 
+    // Stable handle assigned by CritterManager; ids grow in spawn order.
+    int getId() const;
+    void setId(int id);
+
+    // Distance travelled along the map path, in cells. Higher means closer to the exit.
+    SimScalar getProgress() const;
+    // Cells moved per tick at the current speed, including slows.
+    SimScalar getSpeed() const;
+    // Where the critter will be after the given number of ticks at its current speed.
+    SimVec2 predictPosition(SimScalar ticks, int cellSize) const;
+    bool hasReachedExit() const;
+    // Puts the critter straight at a point along the path, as if it had walked there.
+    void placeAt(SimScalar pathProgress);
+    // Pixel position derived from the path progress.
+    SimVec2 getPosition(int cellSize) const;
+    // Position blended between the last two sim ticks; alpha in [0, 1].
+    Vector2 getRenderPosition(int cellSize, float alpha) const;
+
+    // Status effects. A stronger or longer effect replaces a weaker one of the same kind.
+    void applySlow(int percent, int ticks);
+    void applyDamageOverTime(int damagePerTick, int ticks);
+    void tickStatusEffects();
+    bool hasStatusEffects() const;
+    const StatusEffects& getStatusEffects() const;
+
+    // ---------- Swarms ----------
+    // A critter can stand for a whole stack of same-type critters on one cell. The lead
+    // member (the weakest) is the one whose health getHealth reports and single-target
+    // hits land on; when it dies the next weakest member takes over.
+    int getSwarmSize() const;
+    // Damage that hits every member at once (splash, damage over time).
+    // Returns the total damage dealt across the members; adds their overkill to *overkill if given.
+    int takeAreaDamage(int damage, long long* overkill = nullptr);
+    // True if other can merge into this critter: same type and level, same path cell, no status effects.
+    bool canJoinSwarm(const CritterLogic& other) const;
+    // Moves other's members into this swarm; other is left empty and should be deleted.
+    void absorb(CritterLogic& other);
+    // Index of the path cell the critter stands on.
+    int getPathIndex() const;
+
 protected:
     CritterType critterType;
-    MapLogic mapLogic;
-    int frameCounter;
-    int moveInterval;
+    int id;
+    MapLogic& mapLogic;
+    const PathList* path;
+    int moveInterval;  // Frames needed to cross one cell
     int reward;
     int hit_points;
     int maxHealth;
     int strength;
     int level;
-    int x, y;
-    int lastX, lastY;
+    int x, y;          // Cell the critter currently stands on
+    SimScalar progress;
+    SimScalar previousProgress;
+    StatusEffects effects;
+    // Health of the members behind the lead, strongest first, before swarmDamage is taken off
+    std::vector<int, TrackedAllocator<int, MemorySubsystem::CRITTERS>> swarmHealth;
+    int swarmDamage;  // Area damage every member in swarmHealth has taken since joining
+
+    SimVec2 positionAt(SimScalar pathProgress, int cellSize) const;
+    // Hands the lead over to the next weakest member while the lead is dead.
+    void promoteSwarmMember();
 };
 
+// Draws a critter triangle and health bar at a pixel position, with a count badge for swarms.
+void drawCritter(CritterType type, Vector2 position, float healthFraction, int swarmSize = 1);
+
 // Concrete Classes for Different Critters
 
 //Speedy - Higher speed then the rest of the types
@@ -90,16 +168,28 @@ public:
     void render(Vector2 position) override;
 };
 
+typedef std::vector<CritterLogic*, TrackedAllocator<CritterLogic*, MemorySubsystem::CRITTERS>> CritterList;
+
 //Modified CritterManager
 class CritterManager : public ObservableVec
 {
 
 public:
+    // Seeds the spawn RNG from rand(), so the interactive game follows srand().
     CritterManager();
+    // Each simulated game owns its RNG, so runs with the same seed spawn the same waves.
+    explicit CritterManager(unsigned int seed);
     ~CritterManager();
 
     void addCritter(CritterLogic* critter);
+    // Builds a critter in the storage of one that died or left and adds it, so steady-state
+    // waves do not allocate wherever the manager runs. Critters added either way are pooled.
+    CritterLogic* spawnCritter(CritterType type, MapLogic& mapLogic, int level);
     void removeCritter(CritterLogic* critter);
+    // Deletes every critter whose health dropped to zero, in one pass.
+    void removeDeadCritters();
+    // Deletes every critter that reached the exit and returns how many there were, counting swarm members.
+    int removeCrittersAtExit();
 
     void update(MapLogic& mapLogic);
     void startNextWave();
@@ -107,15 +197,58 @@ public:
     
     int getCurrentWave() const;
     int getCrittersSpawned() const;
-    std::vector<CritterLogic*>& getCritters();
+    CritterList& getCritters();
+    const CritterList& getCritters() const;
+    // Returns the live critter with this id, or nullptr once it died or left.
+    CritterLogic* findCritter(int id) const;
+
+    // Re-buckets the critters and recounts them per path cell; call once per tick before querying either.
+    void rebuildSpatialGrid(int cellSize);
+    const SpatialGrid& getSpatialGrid() const;
+    // Not synced with the map until the first update.
+    const PathOccupancy& getPathOccupancy() const;
+
+    // Swarm aggregation: after moving, same-type critters sharing a path cell merge into one
+    // record, so the entity count stays bounded by the path length however dense the waves get.
+    void setSwarmAggregation(bool enabled);
+    bool getSwarmAggregation() const;
+    // Whether wave starts go into MemoryTracker's wave history. That history is global, so
+    // only the interactive game turns this on; simulated games would flood and mix it.
+    void setWaveMemoryRecording(bool enabled);
+    // Live critters counting every swarm member.
+    int getMemberCount() const;
+
+    // Moves big waves in chunks on the pool's threads; nullptr (the default) moves them serially.
+    // A critter's move reads only the shared path and its own state, so the result does not
+    // depend on the thread count. The pool must not be the one this manager is updated from.
+    void setWorkerPool(WorkerPool* pool);
 
 private:
-    std::vector<CritterLogic*> critters;
+    CritterList critters;
     int currentWave = 1;
     int totalCritters = 5;
     int crittersSpawned = 0;
     int spawnFrameCounter = 0;
     int spawnInterval = 120;
+    int nextCritterId = 0;
+    int mapWidth = 0;
+    int mapHeight = 0;
+    SpatialGrid spatialGrid;
+    PathOccupancy pathOccupancy;
+    std::mt19937 rng;
+    bool swarmAggregation = false;
+    bool waveMemoryRecording = false;
+    WorkerPool* workerPool = nullptr;
+    // Per path cell and critter type: index of the swarm lead found there during the current merge pass
+    std::vector<int, TrackedAllocator<int, MemorySubsystem::CRITTERS>> swarmLeads;
+    std::vector<unsigned int, TrackedAllocator<unsigned int, MemorySubsystem::CRITTERS>> swarmLeadPass;
+    unsigned int swarmPass = 0;
+    // Storage of destroyed critters, sizeof(CritterLogic) bytes each, for spawnCritter to reuse
+    std::vector<void*, TrackedAllocator<void*, MemorySubsystem::CRITTERS>> spareCritters;
+
+    void destroyCritter(CritterLogic* critter);
+    void reserveForWave();
+    void mergeSwarms(const PathList& path);
 
 };
 #endif
\ No newline at end of file
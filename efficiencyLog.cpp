@@ -0,0 +1,98 @@
+#include "efficiencyLog.h"
+
+static const char* const towerTypeKeys[towerTypeCount] = { "basic", "splash", "slow", "sniper" };
+
+TowerCounters WaveEfficiency::total() const {
+    TowerCounters sum = TowerCounters();
+    for (const TowerCounters& counters : byType) {
+        sum.add(counters);
+    }
+    return sum;
+}
+
+double WaveEfficiency::damagePerSecond() const {
+    return ticks > 0 ? total().damage * 60.0 / ticks : 0.0;
+}
+
+EfficiencyLog::EfficiencyLog() : wave(0), waveTicks(0), waveLeaks(0), waveStart() {}
+
+void EfficiencyLog::recordTick(const TowerManager& towerManager, int currentWave, int leaked) {
+    if (wave == 0) {
+        wave = currentWave;
+    }
+    // The tick that clears a wave already reports the next one
+    waveTicks++;
+    waveLeaks += leaked;
+    if (currentWave != wave) {
+        closeWave(towerManager);
+        wave = currentWave;
+    }
+}
+
+void EfficiencyLog::finish(const TowerManager& towerManager) {
+    if (waveTicks > 0) {
+        closeWave(towerManager);
+    }
+}
+
+const std::vector<WaveEfficiency>& EfficiencyLog::getWaves() const {
+    return waves;
+}
+
+void EfficiencyLog::closeWave(const TowerManager& towerManager) {
+    TowerCounters totals[towerTypeCount];
+    towerManager.sumCountersByType(totals);
+
+    WaveEfficiency record;
+    record.wave = wave;
+    record.ticks = waveTicks;
+    record.towers = static_cast<int>(towerManager.getTowers().size());
+    record.leaks = waveLeaks;
+    for (int i = 0; i < towerTypeCount; i++) {
+        record.byType[i].damage = totals[i].damage - waveStart[i].damage;
+        record.byType[i].overkill = totals[i].overkill - waveStart[i].overkill;
+        record.byType[i].shots = totals[i].shots - waveStart[i].shots;
+        record.byType[i].wastedShots = totals[i].wastedShots - waveStart[i].wastedShots;
+        record.byType[i].kills = totals[i].kills - waveStart[i].kills;
+        waveStart[i] = totals[i];
+    }
+    waves.push_back(record);
+    waveTicks = 0;
+    waveLeaks = 0;
+}
+
+static void writeCounters(std::ostream& out, const TowerCounters& counters) {
+    out << "," << counters.damage << "," << counters.overkill << "," << counters.shots << ","
+        << counters.wastedShots << "," << counters.kills;
+}
+
+void EfficiencyLog::writeCsv(std::ostream& out) const {
+    out << "wave,ticks,towers,leaks,dps";
+    for (int i = 0; i <= towerTypeCount; i++) {
+        const char* key = i < towerTypeCount ? towerTypeKeys[i] : "total";
+        out << ",damage_" << key << ",overkill_" << key << ",shots_" << key << ",wasted_" << key << ",kills_" << key;
+    }
+    out << "\n";
+    for (const WaveEfficiency& record : waves) {
+        out << record.wave << "," << record.ticks << "," << record.towers << "," << record.leaks << ","
+            << static_cast<long long>(record.damagePerSecond());
+        for (const TowerCounters& counters : record.byType) {
+            writeCounters(out, counters);
+        }
+        writeCounters(out, record.total());
+        out << "\n";
+    }
+}
+
+void EfficiencyLog::writeTowerCsv(std::ostream& out, const TowerManager& towerManager, int cellSize) {
+    out << "tower,type,x,y,level,damage,overkill,shots,wasted,kills\n";
+    const TowerList& towers = towerManager.getTowers();
+    for (size_t i = 0; i < towers.size(); i++) {
+        const Tower* tower = towers[i];
+        out << towerManager.getTowerIdAt(i) << "," << towerTypeKeys[static_cast<int>(tower->getTowerType())] << ","
+            << static_cast<int>(tower->getPosition().x) / cellSize << "," << static_cast<int>(tower->getPosition().y) / cellSize
+            << "," << tower->getLevel();
+        writeCounters(out, tower->getCounters());
+        out << "\n";
+    }
+}
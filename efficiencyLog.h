@@ -0,0 +1,51 @@
+#pragma once
+#ifndef EFFICIENCY_LOG_H
+#define EFFICIENCY_LOG_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "towerLogic.h"
+
+// Tower counters summed over one wave by tower type, with the critters that got through.
+struct WaveEfficiency {
+    int wave;
+    long long ticks;   // How long the wave lasted
+    int towers;        // Standing when the wave ended
+    int leaks;         // Critters that reached the exit, counting swarm members
+    TowerCounters byType[towerTypeCount];  // Indexed by TowerType
+
+    TowerCounters total() const;
+    // Damage per second of sim time at 60 ticks per second.
+    double damagePerSecond() const;
+};
+
+// Turns the towers' running counters into one record per wave. Towers count as their shots
+// land; this only sums them when a wave ends, so watching a game costs one compare per tick.
+class EfficiencyLog {
+public:
+    EfficiencyLog();
+
+    // Call once per tick after leaks were removed, with the wave the critters are on now.
+    void recordTick(const TowerManager& towerManager, int wave, int leaked);
+    // Closes the wave in progress, if it ran at all; for games that stop mid-wave.
+    void finish(const TowerManager& towerManager);
+    // Finished waves, oldest first.
+    const std::vector<WaveEfficiency>& getWaves() const;
+
+    // One row per finished wave.
+    void writeCsv(std::ostream& out) const;
+    // One row per standing tower, at its map cell, with its counters since it was placed.
+    static void writeTowerCsv(std::ostream& out, const TowerManager& towerManager, int cellSize);
+
+private:
+    int wave;
+    long long waveTicks;
+    int waveLeaks;
+    TowerCounters waveStart[towerTypeCount];  // Totals when the running wave began
+    std::vector<WaveEfficiency> waves;
+
+    void closeWave(const TowerManager& towerManager);
+};
+
+#endif
@@ -0,0 +1,171 @@
+#include "gameSimulation.h"
+#include "logger.h"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+static bool parseTowerType(const std::string& word, TowerType& type) {
+    if (word == "basic") { type = TowerType::BASIC; return true; }
+    if (word == "splash") { type = TowerType::SPLASH; return true; }
+    if (word == "slow") { type = TowerType::SLOW; return true; }
+    if (word == "sniper") { type = TowerType::SNIPER; return true; }
+    return false;
+}
+
+static bool parseUpgradeType(const std::string& word, UpgradeType& type) {
+    if (word == "power") { type = UpgradeType::POWER; return true; }
+    if (word == "range") { type = UpgradeType::RANGE; return true; }
+    if (word == "rate") { type = UpgradeType::FIRE_RATE; return true; }
+    return false;
+}
+
+bool loadTowerLayout(const std::string& fileName, std::vector<TowerPlacement>& layout) {
+    std::ifstream file(fileName);
+    if (!file) {
+        LOG_ERROR("Cannot open tower layout {}", fileName);
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream words(line);
+        std::string typeName;
+        if (!(words >> typeName) || typeName[0] == '#') {
+            continue;
+        }
+        TowerPlacement placement;
+        if (!parseTowerType(typeName, placement.type) || !(words >> placement.x >> placement.y)) {
+            LOG_ERROR("Tower layout {} line {}: expected \"<type> <x> <y>\"", fileName, lineNumber);
+            return false;
+        }
+        std::string upgradeName;
+        while (words >> upgradeName) {
+            UpgradeType upgrade;
+            if (!parseUpgradeType(upgradeName, upgrade)) {
+                LOG_ERROR("Tower layout {} line {}: unknown upgrade {}", fileName, lineNumber, upgradeName);
+                return false;
+            }
+            placement.upgrades.push_back(upgrade);
+        }
+        layout.push_back(placement);
+    }
+    return true;
+}
+
+GameSimulation::GameSimulation(MapLogic& mapLogic, const std::vector<TowerPlacement>& layout,
+                               const SimulationConfig& config, unsigned int seed)
+    : mapLogic(mapLogic), config(config), seed(seed), critterManager(seed), towerManager(&critterManager),
+    lives(config.lives), leaks(0), ticks(0), money(config.startingMoney), trace(nullptr) {
+    for (const TowerPlacement& placement : layout) {
+        Tower* tower = createTower(placement.type);
+        tower->setPosition({ (placement.x + 0.5f) * config.cellSize, (placement.y + 0.5f) * config.cellSize });
+        for (UpgradeType upgrade : placement.upgrades) {
+            tower->upgrade(upgrade);
+        }
+        occupants[placement.y * mapLogic.getWidth() + placement.x] = towerManager.addTower(tower);
+    }
+}
+
+bool GameSimulation::isOver() const {
+    return lives <= 0 || critterManager.getCurrentWave() > config.maxWaves || ticks >= config.maxTicks;
+}
+
+int GameSimulation::getCurrentWave() const {
+    return critterManager.getCurrentWave();
+}
+
+bool GameSimulation::applyCommand(const SimCommand& command) {
+    switch (command.type) {
+    case SimCommandType::PLACE_TOWER: {
+        int x = command.cellX;
+        int y = command.cellY;
+        int cell = y * mapLogic.getWidth() + x;
+        int cost = getArchetype(command.towerType).cost;
+        if (x < 0 || y < 0 || x >= mapLogic.getWidth() || y >= mapLogic.getHeight() ||
+            mapLogic.getCellType(x, y) != SCENERY || occupants.count(cell) != 0 || money < cost) {
+            return false;
+        }
+        money -= cost;
+        Tower* tower = createTower(command.towerType);
+        tower->setPosition({ (x + 0.5f) * config.cellSize, (y + 0.5f) * config.cellSize });
+        occupants[cell] = towerManager.addTower(tower);
+        return true;
+    }
+    case SimCommandType::UPGRADE_TOWER: {
+        Tower* tower = towerManager.getTower(command.tower);
+        if (!tower || money < tower->getCost()) {
+            return false;
+        }
+        money -= tower->getCost();
+        towerManager.upgradeTower(command.tower, command.upgradeType);
+        return true;
+    }
+    case SimCommandType::SELL_TOWER: {
+        Tower* tower = towerManager.getTower(command.tower);
+        if (!tower) {
+            return false;
+        }
+        Vector2 pos = tower->getPosition();
+        occupants.erase(static_cast<int>(pos.y) / config.cellSize * mapLogic.getWidth() + static_cast<int>(pos.x) / config.cellSize);
+        money += towerManager.sellTower(command.tower);
+        return true;
+    }
+    case SimCommandType::NONE:
+        return true;
+    }
+    return false;
+}
+
+int GameSimulation::getMoney() const { return money; }
+int GameSimulation::getLives() const { return lives; }
+long long GameSimulation::getTicks() const { return ticks; }
+const CritterList& GameSimulation::getCritters() const { return critterManager.getCritters(); }
+const TowerManager& GameSimulation::getTowerManager() const { return towerManager; }
+const EfficiencyLog& GameSimulation::getEfficiencyLog() const { return efficiency; }
+void GameSimulation::setTrace(TraceWriter* trace) { this->trace = trace; }
+
+// Same order as the interactive loop: towers fire, critters spawn and move, leaks are removed.
+bool GameSimulation::step() {
+    if (isOver()) {
+        return false;
+    }
+    towerManager.updateTowers(config.cellSize);
+    critterManager.update(mapLogic);
+
+    int leaked = critterManager.removeCrittersAtExit();
+    leaks += leaked;
+    lives -= leaked;
+    ticks++;
+    efficiency.recordTick(towerManager, critterManager.getCurrentWave(), leaked);
+    if (trace) {
+        trace->record(ticks, critterManager, towerManager, config.cellSize);
+    }
+    return !isOver();
+}
+
+SimulationResult GameSimulation::run() {
+    auto start = std::chrono::steady_clock::now();
+    while (step()) {
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    efficiency.finish(towerManager);
+
+    SimulationResult result;
+    result.seed = seed;
+    result.won = lives > 0 && critterManager.getCurrentWave() > config.maxWaves;
+    result.survivedWaves = critterManager.getCurrentWave() - 1;
+    if (result.survivedWaves > config.maxWaves) {
+        result.survivedWaves = config.maxWaves;
+    }
+    result.leaks = leaks;
+    result.ticks = ticks;
+    result.seconds = elapsed.count();
+    for (int i = 0; i < towerTypeCount; i++) {
+        result.damageByType[i] = 0;
+    }
+    for (const Tower* tower : towerManager.getTowers()) {
+        result.damageByType[static_cast<int>(tower->getTowerType())] += tower->getDamageDealt();
+    }
+    return result;
+}
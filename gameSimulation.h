@@ -0,0 +1,89 @@
+#pragma once
+#ifndef GAME_SIMULATION_H
+#define GAME_SIMULATION_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "mapLogic.h"
+#include "critterLogic.h"
+#include "towerLogic.h"
+#include "simCommand.h"
+#include "efficiencyLog.h"
+#include "traceWriter.h"
+
+// One tower placed before a simulated game starts, at a map cell.
+struct TowerPlacement {
+    TowerType type;
+    int x;
+    int y;
+    std::vector<UpgradeType> upgrades;
+};
+
+struct SimulationConfig {
+    int maxWaves;        // Surviving this many waves wins the game
+    int lives;           // Critters allowed to reach the exit before the game is lost
+    int cellSize;
+    long long maxTicks;  // Hard stop for layouts that can never clear a wave
+    int startingMoney;   // For towers bought with applyCommand; the layout is free
+};
+
+struct SimulationResult {
+    unsigned int seed;
+    bool won;
+    int survivedWaves;
+    int leaks;
+    long long ticks;
+    double seconds;
+    long long damageByType[towerTypeCount];  // Indexed by TowerType
+};
+
+// Reads a tower layout, one tower per line: "<type> <x> <y> [upgrade...]".
+// Types are basic, splash, slow and sniper; upgrades are power, range and rate.
+// Blank lines and lines starting with '#' are ignored.
+bool loadTowerLayout(const std::string& fileName, std::vector<TowerPlacement>& layout);
+
+// A whole game without any rendering or input. Several can run at once on
+// different threads as long as they share nothing but the (unchanging) map.
+class GameSimulation {
+public:
+    GameSimulation(MapLogic& mapLogic, const std::vector<TowerPlacement>& layout,
+                   const SimulationConfig& config, unsigned int seed);
+
+    // Advances the game by one tick. Returns false once it is over.
+    bool step();
+    // Steps until the game is over and reports how it went.
+    SimulationResult run();
+    bool isOver() const;
+    int getCurrentWave() const;
+
+    // Applies a player action with the same money and cell checks as the interactive game.
+    // Returns false if it was refused.
+    bool applyCommand(const SimCommand& command);
+    int getMoney() const;
+    int getLives() const;
+    long long getTicks() const;
+    const CritterList& getCritters() const;
+    const TowerManager& getTowerManager() const;
+    // Per-wave tower counters; the wave a finished run stopped in is closed by run().
+    const EfficiencyLog& getEfficiencyLog() const;
+    // Records every following tick into trace; null stops recording. The caller owns it.
+    void setTrace(TraceWriter* trace);
+
+private:
+    MapLogic& mapLogic;
+    SimulationConfig config;
+    unsigned int seed;
+    CritterManager critterManager;
+    TowerManager towerManager;  // Declared after critterManager, which its towers point into
+    int lives;
+    int leaks;
+    long long ticks;
+    int money;
+    EfficiencyLog efficiency;
+    TraceWriter* trace;
+    // Towers by cell (y * width + x). Kept per game because the map is shared between games.
+    std::unordered_map<int, TowerId> occupants;
+};
+
+#endif
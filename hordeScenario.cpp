@@ -0,0 +1,246 @@
+#include "hordeScenario.h"
+#include "gameSimulation.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Path rows are this many cells apart; the scenery rows in between hold the towers.
+static const int pathRowSpacing = 4;
+
+HordeScenario::HordeScenario(const HordeConfig& config)
+    : config(config), pool(config.threads), mapLogic(config.mapSize, config.mapSize), critterManager(config.seed),
+    towerManager(&critterManager), rng(config.seed), kills(0), leaks(0), ticks(0), trace(nullptr) {
+    critterManager.setSwarmAggregation(config.swarms);
+    critterManager.setWorkerPool(&pool);
+    buildMap();
+    placeTowers();
+    critterManager.getCritters().reserve(config.critterCount);
+    refillCritters();
+}
+
+// A corridor that sweeps left to right and back down the whole map, so the path is as long as possible.
+void HordeScenario::buildMap() {
+    int first = 1;
+    int last = config.mapSize - 2;
+    int row = 1;
+    bool rightward = true;
+    mapLogic.setEntry(first, row);
+    while (true) {
+        int from = rightward ? first : last;
+        int to = rightward ? last : first;
+        int step = rightward ? 1 : -1;
+        for (int x = from; x != to + step; x += step) {
+            if (mapLogic.getCellType(x, row) == SCENERY) {
+                mapLogic.setCell(x, row, PATH);
+            }
+        }
+        if (row + pathRowSpacing > last) {
+            mapLogic.setExit(to, row);
+            break;
+        }
+        for (int y = row + 1; y <= row + pathRowSpacing; y++) {
+            mapLogic.setCell(to, y, PATH);
+        }
+        row += pathRowSpacing;
+        rightward = !rightward;
+    }
+    mapLogic.getPath();
+}
+
+// Spreads the towers evenly over the scenery rows halfway between two path rows.
+void HordeScenario::placeTowers() {
+    std::vector<PathPoint> sites;
+    for (int y = 1 + pathRowSpacing / 2; y < config.mapSize - 1; y += pathRowSpacing) {
+        for (int x = 2; x < config.mapSize - 2; x++) {
+            if (mapLogic.getCellType(x, y) == SCENERY) {
+                sites.push_back({ x, y });
+            }
+        }
+    }
+    int count = std::min(config.towerCount, static_cast<int>(sites.size()));
+    for (int i = 0; i < count; i++) {
+        const PathPoint& site = sites[static_cast<size_t>(i) * sites.size() / count];
+        Tower* tower = createTower(static_cast<TowerType>(i % towerTypeCount));
+        tower->setPosition({ (site.x + 0.5f) * config.cellSize, (site.y + 0.5f) * config.cellSize });
+        towerManager.addTower(tower);
+    }
+}
+
+void HordeScenario::refillCritters() {
+    float pathEnd = static_cast<float>(mapLogic.getPathLength() - 1);
+    std::uniform_real_distribution<float> progress(0.0f, pathEnd);
+    for (int i = critterManager.getMemberCount(); i < config.critterCount; i++) {
+        CritterLogic* critter = critterManager.spawnCritter(static_cast<CritterType>(rng() % 4), mapLogic, config.critterLevel);
+        critter->placeAt(simFromFloat(progress(rng)));
+    }
+}
+
+void HordeScenario::step() {
+    int before = critterManager.getMemberCount();
+    towerManager.updateTowers(config.cellSize);
+    critterManager.update(mapLogic);
+    int leaked = critterManager.removeCrittersAtExit();
+    leaks += leaked;
+    // The manager may spawn its own wave critters, so count kills from what is left
+    int after = critterManager.getMemberCount() + leaked;
+    kills += before > after ? before - after : 0;
+    refillCritters();
+    ticks++;
+    if (trace) {
+        trace->record(ticks, critterManager, towerManager, config.cellSize);
+    }
+}
+
+int HordeScenario::getThreadCount() const {
+    return pool.getThreadCount();
+}
+
+int HordeScenario::getTowerCount() const {
+    return static_cast<int>(towerManager.getTowers().size());
+}
+
+void HordeScenario::setTrace(TraceWriter* trace) {
+    this->trace = trace;
+}
+
+static double percentile(std::vector<double>& samples, double fraction) {
+    size_t index = static_cast<size_t>(fraction * (samples.size() - 1) + 0.5);
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+// A tower's first shot comes after one cooldown and lands one flight later; the projectile
+// load is only steady once the slowest tower's has landed.
+int HordeScenario::getFullLoadTicks() const {
+    int longest = 0;
+    for (const Tower* tower : towerManager.getTowers()) {
+        float speed = getArchetype(tower->getTowerType()).projectileSpeed;
+        int flight = speed > 0.0f ? static_cast<int>(std::ceil(tower->getRange() * config.cellSize / speed)) : 0;
+        longest = std::max(longest, tower->getCooldownTicks() + flight);
+    }
+    return longest;
+}
+
+HordeResult HordeScenario::run() {
+    int warmupTicks = config.warmupTicks < 0 ? getFullLoadTicks() : config.warmupTicks;
+    for (int i = 0; i < warmupTicks; i++) {
+        step();
+    }
+    kills = 0;
+    leaks = 0;
+
+    std::vector<double> tickMs;
+    tickMs.reserve(config.ticks);
+    for (int i = 0; i < config.ticks; i++) {
+        auto start = std::chrono::steady_clock::now();
+        step();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        tickMs.push_back(elapsed.count());
+    }
+
+    HordeResult result;
+    result.maxMs = tickMs.empty() ? 0.0 : *std::max_element(tickMs.begin(), tickMs.end());
+    result.p50Ms = tickMs.empty() ? 0.0 : percentile(tickMs, 0.50);
+    result.p99Ms = tickMs.empty() ? 0.0 : percentile(tickMs, 0.99);
+    result.peakBytes = MemoryTracker::getTotalPeakBytes();
+    result.kills = kills;
+    result.leaks = leaks;
+    result.records = static_cast<int>(critterManager.getCritters().size());
+    return result;
+}
+
+static void printHordeUsage() {
+    std::cerr << "Usage: --horde [--size N] [--critters N] [--towers N] [--level N] [--ticks N] [--warmup N] [--seed S] [--swarm] [--threads N]\n"
+                 "               [--trace file] [--max-p50-ms X] [--max-p99-ms X] [--max-memory-mb X]   (0 = no budget)\n";
+}
+
+int runHordeCommand(int argc, char** argv) {
+    HordeConfig config = { 512, 100000, 5000, 1, 600, -1, 40, 1, false, 0 };
+    double maxP50Ms = 0.0;
+    double maxP99Ms = 1000.0 / 60.0;  // A tick has to fit in one frame
+    double maxMemoryMb = 0.0;
+    std::string traceFile;
+
+    for (int i = 0; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--swarm") {
+            config.swarms = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            printHordeUsage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (option == "--size") { config.mapSize = std::atoi(value); }
+        else if (option == "--critters") { config.critterCount = std::atoi(value); }
+        else if (option == "--towers") { config.towerCount = std::atoi(value); }
+        else if (option == "--level") { config.critterLevel = std::atoi(value); }
+        else if (option == "--ticks") { config.ticks = std::atoi(value); }
+        else if (option == "--warmup") { config.warmupTicks = std::atoi(value); }
+        else if (option == "--threads") { config.threads = std::atoi(value); }
+        else if (option == "--seed") { config.seed = static_cast<unsigned int>(std::strtoul(value, nullptr, 10)); }
+        else if (option == "--max-p50-ms") { maxP50Ms = std::atof(value); }
+        else if (option == "--max-p99-ms") { maxP99Ms = std::atof(value); }
+        else if (option == "--max-memory-mb") { maxMemoryMb = std::atof(value); }
+        else if (option == "--trace") { traceFile = value; }
+        else {
+            printHordeUsage();
+            return 1;
+        }
+    }
+    if (config.mapSize < pathRowSpacing + 3 || config.critterCount < 0 || config.towerCount < 0 || config.ticks <= 0) {
+        printHordeUsage();
+        return 1;
+    }
+
+    Logger::setLevel(LogLevel::WARN);
+
+    auto start = std::chrono::steady_clock::now();
+    HordeScenario scenario(config);
+    std::chrono::duration<double> setup = std::chrono::steady_clock::now() - start;
+    TraceWriter trace;
+    if (!traceFile.empty()) {
+        if (!trace.open(traceFile)) {
+            Logger::flush();
+            return 1;
+        }
+        scenario.setTrace(&trace);
+    }
+    HordeResult result = scenario.run();
+    bool traced = trace.close();
+    double peakMb = result.peakBytes / (1024.0 * 1024.0);
+
+    std::cout << "map " << config.mapSize << "x" << config.mapSize << ", " << config.critterCount << " critters, "
+              << scenario.getTowerCount() << " towers, " << config.ticks << " ticks on " << scenario.getThreadCount()
+              << " threads (setup " << setup.count() << " s)\n"
+              << "tick p50 " << result.p50Ms << " ms, p99 " << result.p99Ms << " ms, max " << result.maxMs << " ms\n"
+              << "peak tracked memory " << peakMb << " MB\n"
+              << result.kills << " kills, " << result.leaks << " leaks, " << result.records << " critter records\n";
+
+    if (!traceFile.empty()) {
+        std::cout << "trace " << trace.getBytesWritten() / (1024.0 * 1024.0) << " MB, "
+                  << trace.getStallCount() << " stalls\n";
+    }
+
+    bool passed = traced;
+    if (maxP50Ms > 0.0 && result.p50Ms > maxP50Ms) {
+        std::cout << "FAIL: p50 tick time over budget of " << maxP50Ms << " ms\n";
+        passed = false;
+    }
+    if (maxP99Ms > 0.0 && result.p99Ms > maxP99Ms) {
+        std::cout << "FAIL: p99 tick time over budget of " << maxP99Ms << " ms\n";
+        passed = false;
+    }
+    if (maxMemoryMb > 0.0 && peakMb > maxMemoryMb) {
+        std::cout << "FAIL: peak memory over budget of " << maxMemoryMb << " MB\n";
+        passed = false;
+    }
+    std::cout << (passed ? "PASS" : "FAIL") << "\n";
+    Logger::flush();
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#ifndef HORDE_SCENARIO_H
+#define HORDE_SCENARIO_H
+
+#include <random>
+#include <vector>
+#include "mapLogic.h"
+#include "critterLogic.h"
+#include "towerLogic.h"
+#include "workerPool.h"
+#include "traceWriter.h"
+
+struct HordeConfig {
+    int mapSize;        // Width and height of the generated map, in cells
+    int critterCount;   // Live critters kept on the map every tick
+    int towerCount;
+    int critterLevel;
+    int ticks;          // Measured ticks
+    int warmupTicks;    // Ticks run before measuring, while containers reach full size; -1 = until every tower's first shot can land
+    int cellSize;
+    unsigned int seed;
+    bool swarms;        // Merge same-type critters sharing a cell into swarm records
+    int threads;        // For critter movement, 0 = one per core
+};
+
+struct HordeResult {
+    double p50Ms;
+    double p99Ms;
+    double maxMs;
+    std::size_t peakBytes;  // Tracked heap peak over the whole run
+    long long kills;
+    long long leaks;
+    int records;  // Critter objects left at the end; below the critter count when swarms merged
+};
+
+// Production-scale load test: a generated serpentine map packed with critters and lined
+// with towers, stepped headlessly. Critters that die or leak are replaced at random points
+// along the path, so the population and projectile load stay constant.
+class HordeScenario {
+public:
+    explicit HordeScenario(const HordeConfig& config);
+
+    // Same order as GameSimulation::step, then tops the critters back up.
+    void step();
+    HordeResult run();
+    int getThreadCount() const;
+    // Towers actually placed, at most the configured count when the map runs out of sites.
+    int getTowerCount() const;
+    // Records every following tick into trace, so soak runs pay for tracing; the caller owns it.
+    void setTrace(TraceWriter* trace);
+
+private:
+    HordeConfig config;
+    WorkerPool pool;
+    MapLogic mapLogic;
+    CritterManager critterManager;
+    TowerManager towerManager;  // Declared after critterManager, which its towers point into
+    std::mt19937 rng;
+    long long kills;
+    long long leaks;
+    long long ticks;
+    TraceWriter* trace;
+
+    void buildMap();
+    void placeTowers();
+    void refillCritters();
+    int getFullLoadTicks() const;
+};
+
+// Entry point for "--horde": runs the scenario and fails if a budget is exceeded.
+// Returns the process exit code.
+int runHordeCommand(int argc, char** argv);
+
+#endif
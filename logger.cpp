@@ -0,0 +1,150 @@
+#include "logger.h"
+#include <chrono>
+#include <cstring>
+
+std::atomic<int> Logger::minLevel(LOG_COMPILE_LEVEL);
+
+Logger::Logger() : enqueuePos(0), dequeuePos(0), written(0), dropped(0), running(true), output(&std::cout) {
+    for (std::size_t i = 0; i < capacity; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    worker = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger() {
+    running.store(false, std::memory_order_release);
+    if (worker.joinable()) {
+        worker.join();
+    }
+    drain();
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+void Logger::setLevel(LogLevel level) { minLevel.store(static_cast<int>(level), std::memory_order_relaxed); }
+LogLevel Logger::getLevel() { return static_cast<LogLevel>(minLevel.load(std::memory_order_relaxed)); }
+void Logger::setOutput(std::ostream* out) { instance().output.store(out, std::memory_order_release); }
+std::size_t Logger::getDroppedCount() { return instance().dropped.load(std::memory_order_relaxed); }
+
+void Logger::flush() {
+    Logger& logger = instance();
+    // Wait for the worker to write and flush everything enqueued before this call.
+    std::size_t target = logger.enqueuePos.load(std::memory_order_acquire);
+    while (logger.running.load(std::memory_order_acquire) &&
+           logger.written.load(std::memory_order_acquire) < target) {
+        std::this_thread::yield();
+    }
+}
+
+// Bounded multi-producer queue: every slot carries a sequence number telling
+// producers and the consumer whose turn it is, so no locks are needed.
+void Logger::push(const LogRecord& record) {
+    std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = slots[pos & (capacity - 1)];
+        std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.record = record;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return;
+            }
+        }
+        else if (diff < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// Only the worker (or the destructor after joining it) consumes.
+bool Logger::pop(LogRecord& record) {
+    std::size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    Slot& slot = slots[pos & (capacity - 1)];
+    std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1) < 0) {
+        return false;
+    }
+    record = slot.record;
+    slot.sequence.store(pos + capacity, std::memory_order_release);
+    dequeuePos.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+void Logger::drain() {
+    std::ostream& out = *output.load(std::memory_order_acquire);
+    LogRecord record;
+    std::size_t count = 0;
+    while (pop(record)) {
+        write(out, record);
+        count++;
+    }
+    if (count > 0) {
+        out.flush();
+        written.fetch_add(count, std::memory_order_release);
+    }
+}
+
+void Logger::run() {
+    while (running.load(std::memory_order_acquire)) {
+        drain();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+void Logger::write(std::ostream& out, const LogRecord& record) {
+    switch (record.level) {
+    case LogLevel::DEBUG: out << "[DEBUG] "; break;
+    case LogLevel::INFO:  out << "[INFO] "; break;
+    case LogLevel::WARN:  out << "[WARN] "; break;
+    case LogLevel::ERR:   out << "[ERROR] "; break;
+    default: break;
+    }
+    int argIndex = 0;
+    for (const char* c = record.format; *c; c++) {
+        if (c[0] == '{' && c[1] == '}' && argIndex < record.argCount) {
+            const LogArg& arg = record.args[argIndex++];
+            switch (arg.kind) {
+            case LogArg::INT:   out << arg.intValue; break;
+            case LogArg::FLOAT: out << arg.floatValue; break;
+            case LogArg::TEXT:  out << arg.text; break;
+            }
+            c++;
+        }
+        else {
+            out << *c;
+        }
+    }
+    out << '\n';
+}
+
+void Logger::capture(LogRecord& record, int value) { capture(record, static_cast<long long>(value)); }
+void Logger::capture(LogRecord& record, std::size_t value) { capture(record, static_cast<long long>(value)); }
+
+void Logger::capture(LogRecord& record, long long value) {
+    LogArg& arg = record.args[record.argCount++];
+    arg.kind = LogArg::INT;
+    arg.intValue = value;
+}
+
+void Logger::capture(LogRecord& record, double value) {
+    LogArg& arg = record.args[record.argCount++];
+    arg.kind = LogArg::FLOAT;
+    arg.floatValue = value;
+}
+
+void Logger::capture(LogRecord& record, const char* value) {
+    LogArg& arg = record.args[record.argCount++];
+    arg.kind = LogArg::TEXT;
+    std::strncpy(arg.text, value, sizeof(arg.text) - 1);
+    arg.text[sizeof(arg.text) - 1] = '\0';
+}
+
+void Logger::capture(LogRecord& record, const std::string& value) { capture(record, value.c_str()); }
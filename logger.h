@@ -0,0 +1,126 @@
+#pragma once
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <thread>
+
+enum class LogLevel {
+    DEBUG,
+    INFO,
+    WARN,
+    ERR,
+    OFF
+};
+
+// Levels below this are compiled out entirely (0 = DEBUG ... 4 = OFF).
+#ifndef LOG_COMPILE_LEVEL
+#ifdef NDEBUG
+#define LOG_COMPILE_LEVEL 1
+#else
+#define LOG_COMPILE_LEVEL 0
+#endif
+#endif
+
+#define LOG_AT(level, ...) \
+    do { \
+        if (static_cast<int>(level) >= LOG_COMPILE_LEVEL) { \
+            Logger::log(level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LogLevel::WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::ERR, __VA_ARGS__)
+
+// One captured argument. Text is copied inline so the record never points at freed memory.
+struct LogArg {
+    enum Kind { INT, FLOAT, TEXT } kind;
+    union {
+        long long intValue;
+        double floatValue;
+    };
+    char text[32];
+};
+
+// Unformatted log line: the format string must be a literal, "{}" marks each argument.
+struct LogRecord {
+    LogLevel level;
+    const char* format;
+    int argCount;
+    LogArg args[4];
+};
+
+// Asynchronous logger. The calling thread only captures arguments into a lock-free ring buffer;
+// a background thread formats and writes the lines. When the buffer is full the line is dropped
+// rather than blocking the caller.
+class Logger {
+public:
+    static const std::size_t capacity = 1024; // must be a power of two
+
+    template <class... Args>
+    static void log(LogLevel level, const char* format, const Args&... args) {
+        static_assert(sizeof...(Args) <= 4, "Logger supports at most 4 arguments");
+        if (level < getLevel()) {
+            return;
+        }
+        LogRecord record;
+        record.level = level;
+        record.format = format;
+        record.argCount = 0;
+        int unpack[] = { 0, (capture(record, args), 0)... };
+        (void)unpack;
+        instance().push(record);
+    }
+
+    static void setLevel(LogLevel level);
+    static LogLevel getLevel();
+    static void setOutput(std::ostream* out);
+    static std::size_t getDroppedCount();
+
+    // Waits until everything queued so far is written and flushed. Called on shutdown, safe to
+    // call at any time. Only the worker touches the output, so once this returns the caller
+    // may write to the same stream as long as no other thread logs.
+    static void flush();
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        LogRecord record;
+    };
+
+    Slot slots[capacity];
+    std::atomic<std::size_t> enqueuePos;
+    std::atomic<std::size_t> dequeuePos;
+    // Records written and flushed to the output; trails dequeuePos while the worker writes
+    std::atomic<std::size_t> written;
+    std::atomic<std::size_t> dropped;
+    std::atomic<bool> running;
+    std::atomic<std::ostream*> output;
+    std::thread worker;
+
+    static std::atomic<int> minLevel;
+
+    Logger();
+    ~Logger();
+    static Logger& instance();
+
+    void push(const LogRecord& record);
+    bool pop(LogRecord& record);
+    void drain();
+    void run();
+    static void write(std::ostream& out, const LogRecord& record);
+
+    static void capture(LogRecord& record, int value);
+    static void capture(LogRecord& record, long long value);
+    static void capture(LogRecord& record, std::size_t value);
+    static void capture(LogRecord& record, double value);
+    static void capture(LogRecord& record, const char* value);
+    static void capture(LogRecord& record, const std::string& value);
+};
+
+#endif
@@ -9,72 +9,258 @@
 #include "size_query.h"
 #include "towerUI.h"
 #include "critterLogic.h"
+#include "memoryTracker.h"
+#include "logger.h"
+#include "balanceRunner.h"
+#include "simulationThread.h"
+#include "hordeScenario.h"
+#include "batchedEnv.h"
+#include "traceReader.h"
+#include <fstream>
+#include <iostream>
+#include <string>
 
-int main(void)
+// Starts a game straight from files instead of the size prompt and map editor.
+struct LaunchOptions {
+    std::string mapFile;
+    std::string towerFile;
+    int maxWaves = 0;       // 0 = play until the window is closed
+    int lives = 20;         // Headless only; the windowed game has no lives yet
+    unsigned int seed = 0;  // 0 = seed from the clock
+    bool headless = false;
+    std::string statsFile;       // Per-wave tower efficiency CSV, written when the game ends
+    std::string towerStatsFile;  // Per-tower efficiency CSV, written when the game ends
+    std::string traceFile;       // Per-tick state trace, see TraceWriter
+};
+
+static void printLaunchUsage() {
+    std::cerr << "Usage: [--map <file> [--towers <file>] [--waves N] [--seed S] [--headless] [--lives N]\n"
+                 "        [--stats file.csv] [--tower-stats file.csv] [--trace file]]\n"
+                 "       --balance ... | --check-alloc ... | --horde ... | --env-bench ... | --trace-dump ...\n";
+}
+
+// Returns false on an unknown option, a missing value or options that need --map without it.
+static bool parseLaunchOptions(int argc, char** argv, LaunchOptions& options) {
+    for (int i = 0; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--headless") {
+            options.headless = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        if (option == "--map") { options.mapFile = value; }
+        else if (option == "--towers") { options.towerFile = value; }
+        else if (option == "--waves") { options.maxWaves = std::atoi(value); }
+        else if (option == "--lives") { options.lives = std::atoi(value); }
+        else if (option == "--seed") { options.seed = static_cast<unsigned int>(std::strtoul(value, nullptr, 10)); }
+        else if (option == "--stats") { options.statsFile = value; }
+        else if (option == "--tower-stats") { options.towerStatsFile = value; }
+        else if (option == "--trace") { options.traceFile = value; }
+        else {
+            return false;
+        }
+    }
+    return options.mapFile.empty() ? options.towerFile.empty() && !options.headless : true;
+}
+
+// Puts a loaded layout on the map for free, as if the player had bought it.
+static void placeTowers(const std::vector<TowerPlacement>& layout, TowerManager& towerManager, MapLogic& mapLogic, int cellSize) {
+    for (const TowerPlacement& placement : layout) {
+        Tower* tower = createTower(placement.type);
+        tower->setPosition({ (placement.x + 0.5f) * cellSize, (placement.y + 0.5f) * cellSize });
+        for (UpgradeType upgrade : placement.upgrades) {
+            tower->upgrade(upgrade);
+        }
+        mapLogic.setOccupant(placement.x, placement.y, towerManager.addTower(tower));
+    }
+}
+
+// Writes the efficiency CSVs the options ask for. Returns false if a file cannot be written.
+static bool writeEfficiencyStats(const LaunchOptions& options, const EfficiencyLog& log,
+                                 const TowerManager& towerManager, int cellSize) {
+    if (!options.statsFile.empty()) {
+        std::ofstream out(options.statsFile);
+        if (!out) {
+            LOG_ERROR("Cannot write {}", options.statsFile);
+            return false;
+        }
+        log.writeCsv(out);
+    }
+    if (!options.towerStatsFile.empty()) {
+        std::ofstream out(options.towerStatsFile);
+        if (!out) {
+            LOG_ERROR("Cannot write {}", options.towerStatsFile);
+            return false;
+        }
+        EfficiencyLog::writeTowerCsv(out, towerManager, cellSize);
+    }
+    return true;
+}
+
+// One seeded game with no window at all; prints the same CSV row as --balance.
+static int runHeadless(const LaunchOptions& options) {
+    Logger::setLevel(LogLevel::WARN);
+    MapLogic mapLogic;
+    std::vector<TowerPlacement> layout;
+    if (!loadScenario(options.mapFile, options.towerFile, mapLogic, layout)) {
+        Logger::flush();
+        return 1;
+    }
+    SimulationConfig config = { options.maxWaves > 0 ? options.maxWaves : 20, options.lives, 40, 1000000, 0 };
+    GameSimulation game(mapLogic, layout, config, options.seed != 0 ? options.seed : 1);
+    TraceWriter trace;
+    if (!options.traceFile.empty()) {
+        if (!trace.open(options.traceFile)) {
+            Logger::flush();
+            return 1;
+        }
+        game.setTrace(&trace);
+    }
+    std::vector<SimulationResult> results(1, game.run());
+    BalanceRunner::writeCsv(std::cout, results);
+    bool written = trace.close();
+    written = writeEfficiencyStats(options, game.getEfficiencyLog(), game.getTowerManager(), config.cellSize) && written;
+    Logger::flush();
+    return written ? 0 : 1;
+}
+
+int main(int argc, char** argv)
 {
-    std::srand(std::time(0));
+    // Headless Monte Carlo runs for tuning; see runBalanceCommand for the options
+    if (argc > 1 && std::string(argv[1]) == "--balance") {
+        return runBalanceCommand(argc - 2, argv + 2);
+    }
+    // Fails if a steady-state simulation tick allocates; see runAllocationCheckCommand
+    if (argc > 1 && std::string(argv[1]) == "--check-alloc") {
+        return runAllocationCheckCommand(argc - 2, argv + 2);
+    }
+    // Production-scale load test with tick time and memory budgets; see runHordeCommand
+    if (argc > 1 && std::string(argv[1]) == "--horde") {
+        return runHordeCommand(argc - 2, argv + 2);
+    }
+    // Throughput check for the batched training API; see runEnvBenchCommand
+    if (argc > 1 && std::string(argv[1]) == "--env-bench") {
+        return runEnvBenchCommand(argc - 2, argv + 2);
+    }
+    // Prints a per-tick state trace as CSV; see runTraceDumpCommand
+    if (argc > 1 && std::string(argv[1]) == "--trace-dump") {
+        return runTraceDumpCommand(argc - 2, argv + 2);
+    }
+
+    LaunchOptions options;
+    if (!parseLaunchOptions(argc - 1, argv + 1, options)) {
+        printLaunchUsage();
+        return 1;
+    }
+    if (options.headless) {
+        return runHeadless(options);
+    }
+
+    std::srand(options.seed != 0 ? options.seed : static_cast<unsigned int>(std::time(0)));
     //testMain(); 
     //towerMain();
     TowerUIManager towerUIManager;
     CritterManager critterManager;
-    TowerManager::critterManager = &critterManager;
-    TowerManager towerManager;
+    critterManager.setWaveMemoryRecording(true);
+    TowerManager towerManager(&critterManager);
 
-    const int screenWidth = 500;
-    const int screenHeight = 300;
-    InitWindow(screenWidth, screenHeight, "Panel Input Example");
-    SetTargetFPS(60);
+    MapLogic mapLogic;
+    std::vector<TowerPlacement> layout;
+    if (!options.mapFile.empty()) {
+        // A scenario from the command line goes straight to play in one window
+        if (!loadScenario(options.mapFile, options.towerFile, mapLogic, layout)) {
+            Logger::flush();
+            return 1;
+        }
+    }
+    else {
+        const int screenWidth = 500;
+        const int screenHeight = 300;
+        InitWindow(screenWidth, screenHeight, "Panel Input Example");
+        SetTargetFPS(60);
 
-    PanelInput panel;
+        PanelInput panel;
 
-    while (!WindowShouldClose()) {
-        panel.Draw();
-        EndDrawing();
-        panel.Update();
+        while (!WindowShouldClose()) {
+            panel.Draw();
+            EndDrawing();
+            panel.Update();
 
-        BeginDrawing();
-        ClearBackground(RAYWHITE);
+            BeginDrawing();
+            ClearBackground(RAYWHITE);
        
+        }
+        int width = panel.GetWidth();
+        int height = panel.GetHeight();
+       /* const int width = 10;
+        const int height = 10;*/
+        mapLogic = MapLogic(width, height);
     }
-    int width = panel.GetWidth();
-    int height = panel.GetHeight();
-   /* const int width = 10;
-    const int height = 10;*/
 
-    // Create map logic and UI instances
-    MapLogic mapLogic(width, height);
+    // Create the map UI
     MapUI mapUI(mapLogic);
 
-    // Initialize UI
-    mapUI.initUI();
-    int mid = height / 2;
-    for (int x = 0; x < width; x++) {
-        mapLogic.setCell(x, mid, PATH);
-    }
-    mapLogic.setEntry(0, mid);
-    mapLogic.setExit(width - 1, mid);
-    // Main game loop
-    while (!WindowShouldClose()) {
+    if (options.mapFile.empty()) {
+        // Map editor
+        mapUI.initUI();
+        int width = mapLogic.getWidth();
+        int height = mapLogic.getHeight();
+        int mid = height / 2;
+        for (int x = 0; x < width; x++) {
+            mapLogic.setCell(x, mid, PATH);
+        }
+        mapLogic.setEntry(0, mid);
+        mapLogic.setExit(width - 1, mid);
+        // Main game loop
+        while (!WindowShouldClose()) {
         
-        mapLogic.notifyObservers();
+            mapLogic.notifyObservers();
+        }
+        // Closing the window mid-stroke never delivers the release
+        mapUI.finishStroke();
     }
     // Initialize UI
     mapUI.initUI();
+    placeTowers(layout, towerManager, mapLogic, mapUI.getCellSize());
 
-
+    // The game runs on its own thread from here on; this loop only draws and forwards input
+    SimulationThread simulation(mapLogic, towerManager, critterManager, mapUI.getCellSize(), 500);
+    TraceWriter trace;
+    if (!options.traceFile.empty()) {
+        if (!trace.open(options.traceFile)) {
+            mapUI.closeUI();
+            Logger::flush();
+            return 1;
+        }
+        simulation.setTrace(&trace);
+    }
+    simulation.start();
 
     while (!WindowShouldClose()) {
-        
+        const RenderSnapshot& snapshot = simulation.latestSnapshot();
+
         // Draw the UI
-        mapUI.drawUIWithTowersCustom(towerManager, towerUIManager, critterManager);
+        mapUI.drawUIWithTowersCustom(simulation, snapshot, towerUIManager);
 
-        mapUI.drawCritters(critterManager);
-        
-    }
+        mapUI.drawCritters(snapshot);
 
+        // Scripted runs end once the requested waves are done
+        if (options.maxWaves > 0 && snapshot.wave > options.maxWaves) {
+            break;
+        }
+    }
+    simulation.stop();
+    trace.close();
+    bool written = writeEfficiencyStats(options, simulation.getEfficiencyLog(), towerManager, mapUI.getCellSize());
 
     // Close the window and OpenGL context
-    CloseWindow();
+    mapUI.closeUI();
+
+    Logger::flush();
+    MemoryTracker::report(std::cout);
 
-    return 0;
+    return written ? 0 : 1;
 }
@@ -0,0 +1,100 @@
+#include "mapBrush.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+static bool isSingleCell(CellType type) {
+    return type == ENTRY || type == EXIT;
+}
+
+static bool onMap(const MapLogic& mapLogic, int x, int y) {
+    return x >= 0 && y >= 0 && x < mapLogic.getWidth() && y < mapLogic.getHeight();
+}
+
+void paintCell(MapLogic& mapLogic, int x, int y, CellType type) {
+    if (!onMap(mapLogic, x, y)) {
+        return;
+    }
+    if (type == ENTRY) {
+        mapLogic.setEntry(x, y);
+    }
+    else if (type == EXIT) {
+        mapLogic.setExit(x, y);
+    }
+    else if (mapLogic.getCellType(x, y) != type) {
+        mapLogic.setCell(x, y, type);
+    }
+}
+
+// Bresenham, so a fast drag leaves no gaps between the cells the mouse was seen on
+void paintLine(MapLogic& mapLogic, int x0, int y0, int x1, int y1, CellType type) {
+    if (isSingleCell(type)) {
+        paintCell(mapLogic, x1, y1, type);
+        return;
+    }
+    int dx = std::abs(x1 - x0);
+    int dy = -std::abs(y1 - y0);
+    int stepX = x0 < x1 ? 1 : -1;
+    int stepY = y0 < y1 ? 1 : -1;
+    int error = dx + dy;
+    while (true) {
+        paintCell(mapLogic, x0, y0, type);
+        if (x0 == x1 && y0 == y1) {
+            break;
+        }
+        int doubled = 2 * error;
+        if (doubled >= dy) {
+            error += dy;
+            x0 += stepX;
+        }
+        if (doubled <= dx) {
+            error += dx;
+            y0 += stepY;
+        }
+    }
+}
+
+void paintRect(MapLogic& mapLogic, int x0, int y0, int x1, int y1, CellType type) {
+    if (isSingleCell(type)) {
+        paintCell(mapLogic, x1, y1, type);
+        return;
+    }
+    int left = std::max(std::min(x0, x1), 0);
+    int right = std::min(std::max(x0, x1), mapLogic.getWidth() - 1);
+    int top = std::max(std::min(y0, y1), 0);
+    int bottom = std::min(std::max(y0, y1), mapLogic.getHeight() - 1);
+    for (int y = top; y <= bottom; y++) {
+        for (int x = left; x <= right; x++) {
+            paintCell(mapLogic, x, y, type);
+        }
+    }
+}
+
+// Explicit stack instead of recursion, so filling a large open area cannot overflow
+void floodFill(MapLogic& mapLogic, int x, int y, CellType type) {
+    if (!onMap(mapLogic, x, y)) {
+        return;
+    }
+    CellType target = mapLogic.getCellType(x, y);
+    if (isSingleCell(type) || target == type) {
+        paintCell(mapLogic, x, y, type);
+        return;
+    }
+    std::vector<PathPoint> pending;
+    pending.push_back({ x, y });
+    mapLogic.setCell(x, y, type);
+    const int dx[] = { 1, 0, -1, 0 };
+    const int dy[] = { 0, 1, 0, -1 };
+    while (!pending.empty()) {
+        PathPoint cell = pending.back();
+        pending.pop_back();
+        for (int d = 0; d < 4; d++) {
+            int nx = cell.x + dx[d];
+            int ny = cell.y + dy[d];
+            if (onMap(mapLogic, nx, ny) && mapLogic.getCellType(nx, ny) == target) {
+                mapLogic.setCell(nx, ny, type);
+                pending.push_back({ nx, ny });
+            }
+        }
+    }
+}
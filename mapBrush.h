@@ -0,0 +1,21 @@
+#pragma once
+#ifndef MAP_BRUSH_H
+#define MAP_BRUSH_H
+
+#include "mapLogic.h"
+
+// Editor brushes. They paint through MapLogic's setters, so a stroke made inside an
+// edit transaction becomes one undo step and one map change however many cells it covers.
+// Entry and exit are single cells, so the area brushes place them at the end point only.
+// Cells outside the map are skipped.
+
+// Paints one cell, moving the entry or exit there for those types.
+void paintCell(MapLogic& mapLogic, int x, int y, CellType type);
+// Paints every cell on the straight line between two cells, ends included.
+void paintLine(MapLogic& mapLogic, int x0, int y0, int x1, int y1, CellType type);
+// Paints the filled rectangle spanned by two corner cells.
+void paintRect(MapLogic& mapLogic, int x0, int y0, int x1, int y1, CellType type);
+// Repaints the 4-connected region of same-type cells around a cell.
+void floodFill(MapLogic& mapLogic, int x, int y, CellType type);
+
+#endif
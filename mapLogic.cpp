@@ -1,33 +1,384 @@
 #include "mapLogic.h"
 #include <vector>
+#include <queue>
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+#include "logger.h"
 
+const int MapLogic::chunkSize;
+const int MapLogic::undoCapacity;
 
-MapLogic::MapLogic() {}
+static const int chunkArea = MapLogic::chunkSize * MapLogic::chunkSize;
 
-MapLogic::MapLogic(int width, int height) : width(width), height(height) {
-    map.resize(height, std::vector<Cell>(width, { SCENERY, false, false }));
+static unsigned char packCell(CellType type, bool isEntry, bool isExit) {
+    return static_cast<unsigned char>(type | (isEntry ? packedEntryFlag : 0) | (isExit ? packedExitFlag : 0));
+}
+
+MapLogic::MapLogic() : width(0), height(0), chunksX(0), chunksY(0), entryX(-1), entryY(-1), exitX(-1), exitY(-1) {}
+
+MapLogic::MapLogic(int width, int height) : width(width), height(height),
+    chunksX((width + chunkSize - 1) / chunkSize), chunksY((height + chunkSize - 1) / chunkSize),
+    entryX(-1), entryY(-1), exitX(-1), exitY(-1) {
+    chunks.assign(static_cast<size_t>(chunksX) * chunksY, -1 - packCell(SCENERY, false, false));
+}
+
+bool MapLogic::loadFromFile(const std::string& fileName) {
+    std::ifstream file(fileName);
+    if (!file) {
+        LOG_ERROR("Cannot open map file {}", fileName);
+        return false;
+    }
+    std::vector<std::string> rows;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        if (!rows.empty() && line.size() != rows[0].size()) {
+            LOG_ERROR("Map file {} row {} has a different width", fileName, rows.size() + 1);
+            return false;
+        }
+        rows.push_back(line);
+    }
+    if (rows.empty()) {
+        LOG_ERROR("Map file {} is empty", fileName);
+        return false;
+    }
+
+    MapLogic loaded(static_cast<int>(rows[0].size()), static_cast<int>(rows.size()));
+    for (int y = 0; y < loaded.height; y++) {
+        for (int x = 0; x < loaded.width; x++) {
+            switch (rows[y][x]) {
+            case '.': break;
+            case '#': loaded.setCell(x, y, PATH); break;
+            case 'E': loaded.setEntry(x, y); break;
+            case 'X': loaded.setExit(x, y); break;
+            default:
+                LOG_ERROR("Map file {} has an unknown tile at {},{}", fileName, x, y);
+                return false;
+            }
+        }
+    }
+    loaded.compactChunks();
+    width = loaded.width;
+    height = loaded.height;
+    chunksX = loaded.chunksX;
+    chunksY = loaded.chunksY;
+    chunks.swap(loaded.chunks);
+    chunkCells.swap(loaded.chunkCells);
+    freeBlocks.swap(loaded.freeBlocks);
+    occupants.clear();
+    entryX = loaded.entryX;
+    entryY = loaded.entryY;
+    exitX = loaded.exitX;
+    exitY = loaded.exitY;
+    pathDirty = true;
+    version++;
+    // Old undo steps describe a different map
+    editing = false;
+    history.clear();
+    historyStart = 0;
+    undoCount = 0;
+    redoCount = 0;
+    return true;
 }
 
 void MapLogic::setCell(int x, int y, CellType type) {
-    map[y][x].type = type;
+    Cell before = getCell(x, y);
+    writeCell(x, y, static_cast<unsigned char>((packedCell(x, y) & ~packedTypeMask) | type));
+    cellChanged(x, y, before);
 }
 
 Cell MapLogic::getCell(int x, int y) const {
-    return map[y][x];
+    unsigned char packed = packedCell(x, y);
+    Cell cell = { static_cast<CellType>(packed & packedTypeMask), (packed & packedEntryFlag) != 0,
+                  (packed & packedExitFlag) != 0, getOccupant(x, y) };
+    return cell;
+}
+
+CellType MapLogic::getCellType(int x, int y) const {
+    return static_cast<CellType>(packedCell(x, y) & packedTypeMask);
+}
+
+void MapLogic::setOccupant(int x, int y, unsigned int occupant) {
+    if (occupant == 0) {
+        occupants.erase(y * width + x);
+    }
+    else {
+        occupants[y * width + x] = occupant;
+    }
+}
+
+unsigned int MapLogic::getOccupant(int x, int y) const {
+    auto it = occupants.find(y * width + x);
+    return it == occupants.end() ? 0 : it->second;
 }
 
 void MapLogic::setEntry(int x, int y) {
-    map[y][x].type = ENTRY;
-    map[y][x].isEntry = true;
+    Cell before = getCell(x, y);
+    writeCell(x, y, static_cast<unsigned char>((packedCell(x, y) & ~packedTypeMask) | ENTRY | packedEntryFlag));
     entryX = x;
     entryY = y;
+    cellChanged(x, y, before);
 }
 
 void MapLogic::setExit(int x, int y) {
-    map[y][x].type = EXIT;
-    map[y][x].isExit = true;
+    Cell before = getCell(x, y);
+    writeCell(x, y, static_cast<unsigned char>((packedCell(x, y) & ~packedTypeMask) | EXIT | packedExitFlag));
     exitX = x;
     exitY = y;
+    cellChanged(x, y, before);
+}
+
+void MapLogic::cellChanged(int x, int y, const Cell& before) {
+    if (editing) {
+        pendingEdit.cells.push_back({ x, y, before, getCell(x, y) });
+        return;
+    }
+    if ((x == entryX && y == entryY) || (x == exitX && y == exitY)) {
+        refindEndpoints();
+    }
+    pathDirty = true;
+    version++;
+}
+
+unsigned char MapLogic::packedCell(int x, int y) const {
+    int slot = chunks[(y / chunkSize) * chunksX + x / chunkSize];
+    if (slot < 0) {
+        return static_cast<unsigned char>(-1 - slot);
+    }
+    return chunkCells[static_cast<size_t>(slot) * chunkArea + (y % chunkSize) * chunkSize + x % chunkSize];
+}
+
+// Writing a different value into a uniform chunk gives it a block of its own, filled with the old value.
+void MapLogic::writeCell(int x, int y, unsigned char packed) {
+    int& slot = chunks[(y / chunkSize) * chunksX + x / chunkSize];
+    if (slot < 0) {
+        unsigned char uniform = static_cast<unsigned char>(-1 - slot);
+        if (uniform == packed) {
+            return;
+        }
+        int block;
+        if (!freeBlocks.empty()) {
+            block = freeBlocks.back();
+            freeBlocks.pop_back();
+        }
+        else {
+            block = static_cast<int>(chunkCells.size() / chunkArea);
+            chunkCells.resize(chunkCells.size() + chunkArea);
+        }
+        std::fill(chunkCells.begin() + static_cast<size_t>(block) * chunkArea,
+                  chunkCells.begin() + static_cast<size_t>(block + 1) * chunkArea, uniform);
+        slot = block;
+    }
+    chunkCells[static_cast<size_t>(slot) * chunkArea + (y % chunkSize) * chunkSize + x % chunkSize] = packed;
+}
+
+void MapLogic::compactChunk(int chunk) {
+    int slot = chunks[chunk];
+    if (slot < 0) {
+        return;
+    }
+    int left = (chunk % chunksX) * chunkSize;
+    int top = (chunk / chunksX) * chunkSize;
+    int columns = std::min(chunkSize, width - left);
+    int rows = std::min(chunkSize, height - top);
+    const unsigned char* cells = &chunkCells[static_cast<size_t>(slot) * chunkArea];
+    unsigned char first = cells[0];
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < columns; x++) {
+            if (cells[y * chunkSize + x] != first) {
+                return;
+            }
+        }
+    }
+    freeBlocks.push_back(slot);
+    chunks[chunk] = -1 - first;
+}
+
+void MapLogic::compactChunks() {
+    for (int chunk = 0; chunk < static_cast<int>(chunks.size()); chunk++) {
+        compactChunk(chunk);
+    }
+}
+
+int MapLogic::getMixedChunkCount() const {
+    int mixed = 0;
+    for (int slot : chunks) {
+        mixed += slot >= 0 ? 1 : 0;
+    }
+    return mixed;
+}
+
+static bool sameCell(const Cell& a, const Cell& b) {
+    return a.type == b.type && a.isEntry == b.isEntry && a.isExit == b.isExit;
+}
+
+static bool samePoint(const PathPoint& a, const PathPoint& b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+void MapLogic::beginEdit() {
+    if (editing) {
+        return;
+    }
+    editing = true;
+    pendingEdit.cells.clear();
+    pendingEdit.entryBefore = { entryX, entryY };
+    pendingEdit.exitBefore = { exitX, exitY };
+}
+
+void MapLogic::commitEdit() {
+    if (!editing) {
+        return;
+    }
+    editing = false;
+
+    // Keep one change per cell: its state before the first write and after the last one
+    CellChangeList& cells = pendingEdit.cells;
+    std::stable_sort(cells.begin(), cells.end(), [](const CellChange& a, const CellChange& b) {
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    });
+    size_t kept = 0;
+    for (size_t i = 0; i < cells.size(); ) {
+        size_t last = i;
+        while (last + 1 < cells.size() && cells[last + 1].x == cells[i].x && cells[last + 1].y == cells[i].y) {
+            last++;
+        }
+        if (!sameCell(cells[i].before, cells[last].after)) {
+            cells[kept] = cells[i];
+            cells[kept].after = cells[last].after;
+            kept++;
+        }
+        i = last + 1;
+    }
+    cells.resize(kept);
+    // Cells arrive sorted, so each chunk shows up in runs; compacting a chunk twice is harmless
+    int lastChunk = -1;
+    for (const CellChange& change : cells) {
+        int chunk = (change.y / chunkSize) * chunksX + change.x / chunkSize;
+        if (chunk != lastChunk) {
+            compactChunk(chunk);
+            lastChunk = chunk;
+        }
+    }
+    refindEndpoints();
+    pendingEdit.entryAfter = { entryX, entryY };
+    pendingEdit.exitAfter = { exitX, exitY };
+    if (cells.empty() && samePoint(pendingEdit.entryBefore, pendingEdit.entryAfter) &&
+        samePoint(pendingEdit.exitBefore, pendingEdit.exitAfter)) {
+        return;
+    }
+
+    // A new step drops whatever could have been redone; a full ring drops its oldest step
+    if (history.size() < static_cast<size_t>(undoCapacity)) {
+        history.resize(undoCapacity);
+    }
+    if (undoCount == undoCapacity) {
+        historyStart = (historyStart + 1) % undoCapacity;
+        undoCount--;
+    }
+    history[(historyStart + undoCount) % undoCapacity].cells.swap(pendingEdit.cells);
+    MapEdit& stored = history[(historyStart + undoCount) % undoCapacity];
+    stored.entryBefore = pendingEdit.entryBefore;
+    stored.entryAfter = pendingEdit.entryAfter;
+    stored.exitBefore = pendingEdit.exitBefore;
+    stored.exitAfter = pendingEdit.exitAfter;
+    undoCount++;
+    redoCount = 0;
+
+    pathDirty = true;
+    version++;
+}
+
+// Painting over the entry while an older entry tile survives elsewhere would otherwise leave
+// the path search starting on a plain cell. Only a lost endpoint costs a scan, a chunk at a time.
+void MapLogic::refindEndpoints() {
+    bool entryLost = entryX >= 0 && entryX < width && entryY >= 0 && entryY < height && getCellType(entryX, entryY) != ENTRY;
+    bool exitLost = exitX >= 0 && exitX < width && exitY >= 0 && exitY < height && getCellType(exitX, exitY) != EXIT;
+    if (!entryLost && !exitLost) {
+        return;
+    }
+    forEachChunk([&](const MapChunkView& chunk) {
+        for (int y = chunk.y; y < chunk.y + chunk.height; y++) {
+            for (int x = chunk.x; x < chunk.x + chunk.width; x++) {
+                CellType type = chunk.uniform ? chunk.type : getCellType(x, y);
+                if (entryLost && type == ENTRY) {
+                    entryX = x;
+                    entryY = y;
+                    entryLost = false;
+                }
+                if (exitLost && type == EXIT) {
+                    exitX = x;
+                    exitY = y;
+                    exitLost = false;
+                }
+                if (chunk.uniform) {
+                    return;  // Every cell is alike
+                }
+            }
+        }
+    });
+}
+
+bool MapLogic::isEditing() const {
+    return editing;
+}
+
+bool MapLogic::undo() {
+    if (editing || undoCount == 0) {
+        return false;
+    }
+    undoCount--;
+    redoCount++;
+    applyEdit(history[(historyStart + undoCount) % undoCapacity], false);
+    return true;
+}
+
+bool MapLogic::redo() {
+    if (editing || redoCount == 0) {
+        return false;
+    }
+    applyEdit(history[(historyStart + undoCount) % undoCapacity], true);
+    undoCount++;
+    redoCount--;
+    return true;
+}
+
+bool MapLogic::canUndo() const {
+    return !editing && undoCount > 0;
+}
+
+bool MapLogic::canRedo() const {
+    return !editing && redoCount > 0;
+}
+
+// Tower occupancy is left alone; edits only ever describe the terrain.
+void MapLogic::applyEdit(const MapEdit& edit, bool forward) {
+    for (const CellChange& change : edit.cells) {
+        const Cell& state = forward ? change.after : change.before;
+        writeCell(change.x, change.y, packCell(state.type, state.isEntry, state.isExit));
+    }
+    int lastChunk = -1;
+    for (const CellChange& change : edit.cells) {
+        int chunk = (change.y / chunkSize) * chunksX + change.x / chunkSize;
+        if (chunk != lastChunk) {
+            compactChunk(chunk);
+            lastChunk = chunk;
+        }
+    }
+    const PathPoint& entry = forward ? edit.entryAfter : edit.entryBefore;
+    const PathPoint& exit = forward ? edit.exitAfter : edit.exitBefore;
+    entryX = entry.x;
+    entryY = entry.y;
+    exitX = exit.x;
+    exitY = exit.y;
+    pathDirty = true;
+    version++;
 }
 
 int MapLogic::getWidth() const {
@@ -54,4 +405,70 @@ void MapLogic::notifyObservers() {
     Notify();
 }
 
-std::vector<std::vector<Cell>> MapLogic::getMap() { return map; }
+
+const PathList& MapLogic::getPath() {
+    if (pathDirty) {
+        buildPath();
+    }
+    return path;
+}
+
+unsigned int MapLogic::getVersion() const {
+    return version;
+}
+
+int MapLogic::getPathLength() {
+    return static_cast<int>(getPath().size());
+}
+
+// Breadth-first search from the entry, then walk the parent links back from the exit.
+void MapLogic::buildPath() {
+    pathDirty = false;
+    path.clear();
+    if (entryX < 0 || entryX >= width || entryY < 0 || entryY >= height ||
+        exitX < 0 || exitX >= width || exitY < 0 || exitY >= height) {
+        return;
+    }
+
+    // Parents are kept only for cells the search reached, so the scratch memory
+    // follows the walkable area rather than the size of the map
+    std::unordered_map<int, int> parent;
+    std::queue<int> frontier;
+    int start = entryY * width + entryX;
+    int goal = exitY * width + exitX;
+    parent[start] = start;
+    frontier.push(start);
+
+    const int dx[] = { 1, 0, -1, 0 };
+    const int dy[] = { 0, 1, 0, -1 };
+    while (!frontier.empty() && parent.count(goal) == 0) {
+        int current = frontier.front();
+        frontier.pop();
+        int cx = current % width;
+        int cy = current / width;
+        for (int d = 0; d < 4; d++) {
+            int nx = cx + dx[d];
+            int ny = cy + dy[d];
+            if (nx < 0 || nx >= width || ny < 0 || ny >= height) {
+                continue;
+            }
+            int next = ny * width + nx;
+            CellType type = getCellType(nx, ny);
+            if ((type == PATH || type == EXIT) && parent.count(next) == 0) {
+                parent[next] = current;
+                frontier.push(next);
+            }
+        }
+    }
+
+    if (parent.count(goal) == 0) {
+        return;
+    }
+    for (int cell = goal; ; cell = parent[cell]) {
+        path.push_back({ cell % width, cell / width });
+        if (cell == start) {
+            break;
+        }
+    }
+    std::reverse(path.begin(), path.end());
+}
@@ -2,7 +2,10 @@
 #define MAPLOGIC_H
 
 #include <vector>
+#include <string>
+#include <unordered_map>
 #include "ObservableVec.h"
+#include "memoryTracker.h"
 
 enum CellType {
     PATH,
@@ -15,16 +18,64 @@ struct Cell {
     CellType type;
     bool isEntry;
     bool isExit;
+    unsigned int occupant;  // TowerId of the tower standing here, 0 if none
 };
 
+// One cell on the precomputed critter path
+struct PathPoint {
+    int x;
+    int y;
+};
+
+typedef std::vector<PathPoint, TrackedAllocator<PathPoint, MemorySubsystem::MAP>> PathList;
+
+// One cell as it was before and after an edit
+struct CellChange {
+    int x;
+    int y;
+    Cell before;
+    Cell after;
+};
+
+typedef std::vector<CellChange, TrackedAllocator<CellChange, MemorySubsystem::MAP>> CellChangeList;
+
+// Everything one edit transaction changed: only the cells it touched, one entry per cell
+struct MapEdit {
+    CellChangeList cells;
+    PathPoint entryBefore, entryAfter;
+    PathPoint exitBefore, exitAfter;
+};
+
+// One chunk of the map as seen by forEachChunk, clipped to the map edge
+struct MapChunkView {
+    int x, y;           // First cell
+    int width, height;  // In cells
+    bool uniform;       // Every cell has the same type and entry/exit flags
+    CellType type;      // Type of every cell when uniform
+};
+
+// Map storage is charged to the MAP subsystem, so copies of the grid show up in the memory report
+typedef std::vector<int, TrackedAllocator<int, MemorySubsystem::MAP>> ChunkTable;
+typedef std::vector<unsigned char, TrackedAllocator<unsigned char, MemorySubsystem::MAP>> ChunkCells;
+typedef std::unordered_map<int, unsigned int, std::hash<int>, std::equal_to<int>,
+    TrackedAllocator<std::pair<const int, unsigned int>, MemorySubsystem::MAP>> OccupantMap;
+
 class MapLogic: public ObservableVec {
 public:
     MapLogic();
     MapLogic(int width, int height);
 
+    // Replaces the map with a text grid: '.' scenery, '#' path, 'E' entry, 'X' exit.
+    // Returns false and leaves the map untouched if the file is missing or malformed.
+    bool loadFromFile(const std::string& fileName);
+
     void setCell(int x, int y, CellType type);
     Cell getCell(int x, int y) const;
-    std::vector<std::vector<Cell>> getMap();
+    // Reads only the type, so it never races with occupancy updates from the simulation thread.
+    CellType getCellType(int x, int y) const;
+    // Tower occupancy does not change the path, so it leaves the version alone.
+    void setOccupant(int x, int y, unsigned int occupant);
+    unsigned int getOccupant(int x, int y) const;
 
     void setEntry(int x, int y);
     void setExit(int x, int y);
@@ -37,12 +88,111 @@ public:
     int getExitY() const;
     void notifyObservers();
 
+    // Cells from entry to exit (inclusive) along the shortest walkable route.
+    // Rebuilt on demand after the map changes; empty if the exit cannot be reached.
+    const PathList& getPath();
+    int getPathLength();
+
+    // Bumped by every edit, so caches derived from the map can tell they are stale.
+    unsigned int getVersion() const;
+
+    // ---------- Chunked storage ----------
+    // Cells live in chunkSize x chunkSize chunks. A chunk whose cells are all alike is kept as
+    // that one cell; only mixed chunks hold a byte per cell. Tower occupancy is kept apart,
+    // for occupied cells only, so a huge mostly-scenery map costs a few bytes per chunk.
+    static const int chunkSize = 32;
+    // Calls visit(const MapChunkView&) for every chunk, row by row, so a whole uniform chunk
+    // can be drawn or checked at once.
+    template <class Visitor>
+    void forEachChunk(Visitor visit) const;
+    // Calls visit(x, y, occupant) for every cell with a tower on it.
+    template <class Visitor>
+    void forEachOccupant(Visitor visit) const;
+    // Chunks holding a byte per cell; the others are stored as a single value.
+    int getMixedChunkCount() const;
+    // Turns mixed chunks whose cells have become alike back into single values.
+    // Transactions and loadFromFile do this for the chunks they touched.
+    void compactChunks();
+
+    // ---------- Edit transactions ----------
+    // Between beginEdit and commitEdit, setCell, setEntry and setExit only record what they change.
+    // The commit bumps the version and invalidates the path once for the whole batch and stores
+    // the changes as one undo step. Edits made outside a transaction are not undoable.
+    void beginEdit();
+    void commitEdit();
+    bool isEditing() const;
+    // Step back or forward through the last undoCapacity transactions. Return false if there is none.
+    bool undo();
+    bool redo();
+    bool canUndo() const;
+    bool canRedo() const;
+
+    static const int undoCapacity = 64;
+
 private:
     int width;
     int height;
-    std::vector<std::vector<Cell>> map;
+    int chunksX;
+    int chunksY;
+    // Per chunk: index of its block in chunkCells, or -1 - packed cell for a uniform chunk
+    ChunkTable chunks;
+    ChunkCells chunkCells;  // chunkSize * chunkSize packed cells per block
+    ChunkTable freeBlocks;  // Blocks of chunkCells no chunk uses any more
+    OccupantMap occupants;  // Keyed by y * width + x
     int entryX, entryY;
     int exitX, exitY;
+    PathList path;
+    bool pathDirty = true;
+    unsigned int version = 0;
+
+    bool editing = false;
+    MapEdit pendingEdit;
+    // Ring buffer of committed edits: undoCount steps to undo, then redoCount undone steps to redo
+    std::vector<MapEdit, TrackedAllocator<MapEdit, MemorySubsystem::MAP>> history;
+    int historyStart = 0;
+    int undoCount = 0;
+    int redoCount = 0;
+
+    void buildPath();
+    unsigned char packedCell(int x, int y) const;
+    void writeCell(int x, int y, unsigned char packed);
+    // Collapses a chunk to a single value if its cells inside the map are all alike.
+    void compactChunk(int chunk);
+    // Records a change inside a transaction, or invalidates the path right away outside one.
+    void cellChanged(int x, int y, const Cell& before);
+    // Points the entry or exit at a surviving tile of its type once its own tile was painted over.
+    void refindEndpoints();
+    // Writes one side of an edit back into the map.
+    void applyEdit(const MapEdit& edit, bool forward);
 };
 
+// Packed cell: bits 0-1 type, bit 2 isEntry, bit 3 isExit
+const unsigned char packedTypeMask = 0x3;
+const unsigned char packedEntryFlag = 0x4;
+const unsigned char packedExitFlag = 0x8;
+
+template <class Visitor>
+void MapLogic::forEachChunk(Visitor visit) const {
+    for (int cy = 0; cy < chunksY; cy++) {
+        for (int cx = 0; cx < chunksX; cx++) {
+            int slot = chunks[cy * chunksX + cx];
+            MapChunkView view;
+            view.x = cx * chunkSize;
+            view.y = cy * chunkSize;
+            view.width = width - view.x < chunkSize ? width - view.x : chunkSize;
+            view.height = height - view.y < chunkSize ? height - view.y : chunkSize;
+            view.uniform = slot < 0;
+            view.type = slot < 0 ? static_cast<CellType>((-1 - slot) & packedTypeMask) : SCENERY;
+            visit(view);
+        }
+    }
+}
+
+template <class Visitor>
+void MapLogic::forEachOccupant(Visitor visit) const {
+    for (const auto& entry : occupants) {
+        visit(entry.first % width, entry.first / width, entry.second);
+    }
+}
+
 #endif // MAPLOGIC_H
@@ -1,14 +1,15 @@
 #include "mapUi.h"
 #include "mapLogic.h"
+#include "mapBrush.h"
 
 #include "raylib.h"
+#include "textCache.h"
+#include <algorithm>
 #include <sstream>
 #include <vector>
-#include <stack>
-#include <tuple>
 
 
-MapUI::MapUI(MapLogic& mapLogic): mapLogic(mapLogic), observable(&mapLogic), cellSize(40), selectedTile(PATH), validationMessage("") {
+MapUI::MapUI(MapLogic& mapLogic): mapLogic(mapLogic), observable(&mapLogic), cellSize(40), selectedTile(PATH), brush(EditBrush::PENCIL), stroking(false), strokeX(0), strokeY(0), lastX(0), lastY(0), validationMessage(""), renderAlpha(1.0f), showCoverage(true), showEfficiency(false), efficiencyWave(0), hudLayer(), drawnHud(), hudValid(false) {
     observable->Attach(this); 
 }
 
@@ -19,6 +20,17 @@ void MapUI::initUI()
     SetTargetFPS(60);
 }
 
+void MapUI::closeUI()
+{
+    // GPU resources must go before the context does
+    if (hudLayer.id != 0) {
+        UnloadRenderTexture(hudLayer);
+        hudLayer = RenderTexture2D();
+    }
+    hudValid = false;
+    CloseWindow();
+}
+
 MapUI::~MapUI() {
     if (observable) {
         observable->Detach(this); // Remove observer before destruction
@@ -41,27 +53,61 @@ void MapUI::updateUI()
     if (IsKeyPressed(KEY_FOUR))
         selectedTile = EXIT;
 
-    // Handle user input to place selected tiles
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) || IsMouseButtonPressed(MOUSE_RIGHT_BUTTON))
+    // Switch brush
+    if (IsKeyPressed(KEY_P))
+        brush = EditBrush::PENCIL;
+    if (IsKeyPressed(KEY_L))
+        brush = EditBrush::LINE;
+    if (IsKeyPressed(KEY_R))
+        brush = EditBrush::RECT;
+    if (IsKeyPressed(KEY_F))
+        brush = EditBrush::FILL;
+
+    bool control = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+    if (control && IsKeyPressed(KEY_Z))
+        mapLogic.undo();
+    if (control && IsKeyPressed(KEY_Y))
+        mapLogic.redo();
+
+    // Paint with the selected brush. Everything from press to release is one transaction,
+    // so a stroke is one undo step and invalidates the path once.
+    int mouseX = GetMouseX();
+    int mouseY = GetMouseY();
+    int x = mouseX / cellSize;
+    int y = mouseY / cellSize;
+    bool onMap = mouseX >= 0 && mouseY >= 0 && x < mapLogic.getWidth() && y < mapLogic.getHeight();
+
+    // Without focus the release may never arrive, so keep what was painted so far
+    if (stroking && !IsWindowFocused())
+        finishStroke();
+
+    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && onMap)
     {
-        int x = GetMouseX() / cellSize;
-        int y = GetMouseY() / cellSize;
-
-        if (x < mapLogic.getWidth() && y < mapLogic.getHeight())
-        {
-            if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
-            {
-                mapLogic.setCell(x, y, selectedTile);
-                if (selectedTile == ENTRY)
-                {
-                    mapLogic.setEntry(x, y);
-                }
-                else if (selectedTile == EXIT)
-                {
-                    mapLogic.setExit(x, y);
-                }
-            }
-        }
+        mapLogic.beginEdit();
+        stroking = true;
+        strokeX = lastX = x;
+        strokeY = lastY = y;
+        if (brush == EditBrush::PENCIL)
+            paintCell(mapLogic, x, y, selectedTile);
+        else if (brush == EditBrush::FILL)
+            floodFill(mapLogic, x, y, selectedTile);
+    }
+    if (stroking && brush == EditBrush::PENCIL && onMap && (x != lastX || y != lastY))
+    {
+        paintLine(mapLogic, lastX, lastY, x, y, selectedTile);
+        lastX = x;
+        lastY = y;
+    }
+    if (stroking && !IsMouseButtonDown(MOUSE_LEFT_BUTTON))
+    {
+        // Releasing off the map ends the shape at the nearest map cell
+        x = x < 0 ? 0 : (x >= mapLogic.getWidth() ? mapLogic.getWidth() - 1 : x);
+        y = y < 0 ? 0 : (y >= mapLogic.getHeight() ? mapLogic.getHeight() - 1 : y);
+        if (brush == EditBrush::LINE)
+            paintLine(mapLogic, strokeX, strokeY, x, y, selectedTile);
+        else if (brush == EditBrush::RECT)
+            paintRect(mapLogic, strokeX, strokeY, x, y, selectedTile);
+        finishStroke();
     }
 
     // Validate map when the button is clicked
@@ -78,6 +124,7 @@ void MapUI::updateUI()
         if (CheckCollisionPointRec(Vector2{(float)GetMouseX(), (float)GetMouseY()},
                                    Rectangle{(float)buttonX, (float)buttonY, (float)buttonWidth, (float)buttonHeight}))
         {
+            finishStroke();
             if (validateMap())
             {
                 validationMessage = "MAP VALID";
@@ -87,22 +134,42 @@ void MapUI::updateUI()
     }
 }
 
+void MapUI::finishStroke()
+{
+    if (!stroking)
+        return;
+    mapLogic.commitEdit();
+    stroking = false;
+}
+
 bool MapUI::validateMap()
 {
-    // Check for exactly one entry and one exit tile
+    // Check for exactly one entry and one exit tile; uniform chunks are counted whole
     int entryCount = 0, exitCount = 0;
 
-    for (int y = 0; y < mapLogic.getHeight(); ++y)
+    mapLogic.forEachChunk([&](const MapChunkView& chunk)
     {
-        for (int x = 0; x < mapLogic.getWidth(); ++x)
+        if (chunk.uniform)
         {
-            CellType type = mapLogic.getCell(x, y).type;
-            if (type == ENTRY)
-                entryCount++;
-            if (type == EXIT)
-                exitCount++;
+            int cells = chunk.width * chunk.height;
+            if (chunk.type == ENTRY)
+                entryCount += cells;
+            if (chunk.type == EXIT)
+                exitCount += cells;
+            return;
         }
-    }
+        for (int y = chunk.y; y < chunk.y + chunk.height; ++y)
+        {
+            for (int x = chunk.x; x < chunk.x + chunk.width; ++x)
+            {
+                CellType type = mapLogic.getCellType(x, y);
+                if (type == ENTRY)
+                    entryCount++;
+                if (type == EXIT)
+                    exitCount++;
+            }
+        }
+    });
 
     if (entryCount != 1)
     {
@@ -116,163 +183,49 @@ bool MapUI::validateMap()
         return false;
     }
 
-    // Find the entry point
-    int startX, startY;
-    bool foundEntry = false;
-
-    for (int y = 0; y < mapLogic.getHeight(); ++y)
-    {
-        for (int x = 0; x < mapLogic.getWidth(); ++x)
-        {
-            if (mapLogic.getCell(x, y).type == ENTRY)
-            {
-                startX = x;
-                startY = y;
-                foundEntry = true;
-                break;
-            }
-        }
-        if (foundEntry)
-            break;
-    }
-
-    // Create a visited grid for path tracking
-    std::vector<std::vector<bool>> visited(mapLogic.getHeight(), std::vector<bool>(mapLogic.getWidth(), false));
-    std::stack<std::pair<int, int>> stack;
-    stack.push({ startX, startY });
-    visited[startY][startX] = true;
-
-    // Directions to move on the map (Right, Down, Left, Up)
-    std::vector<std::pair<int, int>> directions = {
-        {1, 0},  // Right
-        {0, 1},  // Down
-        {-1, 0}, // Left
-        {0, -1}  // Up
-    };
-
-    // DFS or BFS to check connectivity from entry point
-    while (!stack.empty())
-    {
-        int x, y;
-        std::tie(x, y) = stack.top();
-        stack.pop();
-
-        // Check all 4 directions
-        for (const auto& direction : directions)
-        {
-            int dx = direction.first;
-            int dy = direction.second;
-
-            int nx = x + dx, ny = y + dy;
-            if (nx >= 0 && nx < mapLogic.getWidth() && ny >= 0 && ny < mapLogic.getHeight())
-            {
-                // Check if the tile is walkable and hasn't been visited
-                if (!visited[ny][nx] && (mapLogic.getCell(nx, ny).type == PATH || mapLogic.getCell(nx, ny).type == EXIT))
-                {
-                    visited[ny][nx] = true;
-                    stack.push({ nx, ny });
-                }
-            }
-        }
-    }
-
-    // Now check if the exit is reachable
-    bool exitReachable = false;
-    for (int y = 0; y < mapLogic.getHeight(); ++y)
-    {
-        for (int x = 0; x < mapLogic.getWidth(); ++x)
-        {
-            if (mapLogic.getCell(x, y).type == EXIT && visited[y][x])
-            {
-                exitReachable = true;
-                break;
-            }
-        }
-        if (exitReachable)
-            break;
-    }
-
-    if (!exitReachable)
+    // The critters' own breadth-first path; empty if the exit cannot be reached. MapLogic keeps
+    // its entry and exit on surviving tiles, so it runs between the tiles counted above.
+    const PathList& path = mapLogic.getPath();
+    if (path.empty())
     {
         validationMessage = "Invalid: Path is not connected between entry and exit.";
         return false;
     }
 
-    // Now let's check for dead-ends that could block the critter's path
-    std::vector<std::vector<bool>> deadEndVisited(mapLogic.getHeight(), std::vector<bool>(mapLogic.getWidth(), false));
-    bool deadEndFound = false;
-
-    // Start from the entry point again and make sure critter doesn't get stuck in a dead-end loop
-    stack.push({ startX, startY });
-    deadEndVisited[startY][startX] = true;
-
-    while (!stack.empty())
+    // There is only one path if every walkable tile touching it is its own neighbour on it:
+    // a branch, loop or widening would touch a tile the shortest path skips. This looks at
+    // the path's cells only, so it costs the same on any map size.
+    const int dx[] = { 1, 0, -1, 0 };
+    const int dy[] = { 0, 1, 0, -1 };
+    for (size_t i = 0; i < path.size(); ++i)
     {
-        int x, y;
-        std::tie(x, y) = stack.top();
-        stack.pop();
-
-        // Check all 4 directions for potential dead-ends
-        bool hasValidNeighbor = false;
-        for (const auto& direction : directions)
+        for (int d = 0; d < 4; ++d)
         {
-            int dx = direction.first;
-            int dy = direction.second;
-
-            int nx = x + dx, ny = y + dy;
-            if (nx >= 0 && nx < mapLogic.getWidth() && ny >= 0 && ny < mapLogic.getHeight())
+            int nx = path[i].x + dx[d];
+            int ny = path[i].y + dy[d];
+            if (nx < 0 || nx >= mapLogic.getWidth() || ny < 0 || ny >= mapLogic.getHeight())
+            {
+                continue;
+            }
+            CellType type = mapLogic.getCellType(nx, ny);
+            if (type != PATH && type != EXIT)
             {
-                // We only care about walkable tiles that haven't been visited yet
-                if (!deadEndVisited[ny][nx] && (mapLogic.getCell(nx, ny).type == PATH || mapLogic.getCell(nx, ny).type == EXIT))
-                {
-                    // If we find a valid neighbor, mark it as visited and continue exploring
-                    hasValidNeighbor = true;
-                    deadEndVisited[ny][nx] = true;
-                    stack.push({ nx, ny });
-                }
+                continue;
+            }
+            bool previous = i > 0 && path[i - 1].x == nx && path[i - 1].y == ny;
+            bool next = i + 1 < path.size() && path[i + 1].x == nx && path[i + 1].y == ny;
+            if (!previous && !next)
+            {
+                validationMessage = "Invalid: There can only be 1 path.";
+                return false;
             }
         }
-
-        // If a tile has no valid neighbor to proceed to, it's a dead end
-        if (!hasValidNeighbor && (mapLogic.getCell(x, y).type != EXIT)) // Only consider dead-ends that are not the exit
-        {
-            deadEndFound = true;
-            break;  // We found a dead-end, no need to continue
-        }
-    }
-
-    if (deadEndFound)
-    {
-        validationMessage = "Invalid: There can only be 1 path.";
-        return false;
     }
 
     // If no issues found, return true
     return true;
 }
 
-void MapUI::dfs(int x, int y, std::vector<std::vector<bool>> &visited)
-{
-    // Boundary checks
-    if (x < 0 || x >= mapLogic.getWidth() || y < 0 || y >= mapLogic.getHeight() || visited[y][x])
-    {
-        return;
-    }
-
-    if (mapLogic.getCell(x, y).type != PATH && mapLogic.getCell(x, y).type != ENTRY && mapLogic.getCell(x, y).type != EXIT)
-    {
-        return; // Only traverse paths and entry points and exit
-    }
-
-    visited[y][x] = true;
-
-    // Move in all 4 directions (up, down, left, right)
-    dfs(x + 1, y, visited);
-    dfs(x - 1, y, visited);
-    dfs(x, y + 1, visited);
-    dfs(x, y - 1, visited);
-}
-
 /**
  * Draw a right-aligned text block.
  *
@@ -288,11 +241,12 @@ void DrawRightAlignedTextBlock(const char *lines[], const Color colors[], int nu
 {
     int screenWidth = GetScreenWidth();
     int maxWidth = 0;
+    TextCache& cache = uiTextCache();
 
-    // Find the maximum width among the lines.
+    // Find the maximum width among the lines; each line is only measured the first time it is seen.
     for (int i = 0; i < numLines; i++)
     {
-        int w = MeasureText(lines[i], fontSize);
+        int w = cache.measure(lines[i], fontSize);
         if (w > maxWidth)
         {
             maxWidth = w;
@@ -316,37 +270,30 @@ void MapUI::drawUI()
     ClearBackground(RAYWHITE);
 
     // Draw the grid
-    for (int y = 0; y < mapLogic.getHeight(); ++y)
+    drawMapGrid();
+    // Outline the shape a line or rectangle stroke will paint on release
+    if (stroking && (brush == EditBrush::LINE || brush == EditBrush::RECT))
     {
-        for (int x = 0; x < mapLogic.getWidth(); ++x)
+        int x = GetMouseX() / cellSize;
+        int y = GetMouseY() / cellSize;
+        if (brush == EditBrush::RECT)
         {
-            Color color;
-            CellType cellType = mapLogic.getCell(x, y).type;
-
-            if (cellType == PATH)
-            {
-                color = BLUE;
-            }
-            else if (cellType == SCENERY)
-            {
-                color = LIGHTGRAY;
-            }
-            else if (cellType == ENTRY)
-            {
-                color = GREEN;
-            }
-            else if (cellType == EXIT)
-            {
-                color = RED;
-            }
-
-            DrawRectangle(x * cellSize, y * cellSize, cellSize, cellSize, color);
-            DrawRectangleLines(x * cellSize, y * cellSize, cellSize, cellSize, DARKGRAY);
+            int left = x < strokeX ? x : strokeX;
+            int top = y < strokeY ? y : strokeY;
+            int right = x < strokeX ? strokeX : x;
+            int bottom = y < strokeY ? strokeY : y;
+            DrawRectangleLines(left * cellSize, top * cellSize, (right - left + 1) * cellSize, (bottom - top + 1) * cellSize, BLACK);
+        }
+        else
+        {
+            DrawLine(strokeX * cellSize + cellSize / 2, strokeY * cellSize + cellSize / 2,
+                     x * cellSize + cellSize / 2, y * cellSize + cellSize / 2, BLACK);
         }
     }
-    // Display the selected tile
+
+    // Display the selected tile and brush
     std::ostringstream tileText;
-    tileText << "Current Tile: " << tileTypeToString(selectedTile);
+    tileText << "Current Tile: " << tileTypeToString(selectedTile) << "  Brush: " << brushToString(brush);
     DrawText(tileText.str().c_str(), 10, 10, 20, DARKGRAY);
 
     const char* legendLines[] = {
@@ -354,16 +301,20 @@ void MapUI::drawUI()
         "1 - Path (Blue)",
         "2 - Scenery (Gray)",
         "3 - Entry (Green)",
-        "4 - Exit (Red)" };
+        "4 - Exit (Red)",
+        "P/L/R/F - Pencil/Line/Rect/Fill",
+        "Ctrl+Z / Ctrl+Y - Undo/Redo" };
 
     Color legendColors[] = {
         DARKGRAY,
         BLUE,
         LIGHTGRAY,
         GREEN,
-        RED };
+        RED,
+        DARKGRAY,
+        DARKGRAY };
 
-    int numLines = 5;
+    int numLines = 7;
     int fontSize = 20;
     int spacing = 30; // 30 pixels between lines.
     int margin = 10;  // 10 pixels from the right edge.
@@ -398,36 +349,42 @@ void MapUI::drawUI()
 // Make sure to include your CritterManager header as well.
 #include "critterLogic.h"  // For CritterManager
 
-void MapUI::drawUIWithTowersCustom(TowerManager& towerManager, TowerUIManager& towerUIManager, CritterManager& critterManager) {
+int MapUI::getCellSize() const {
+    return cellSize;
+}
+
+void MapUI::drawUIWithTowersCustom(SimulationThread& simulation, const RenderSnapshot& snapshot, TowerUIManager& towerUIManager) {
     // --- Persistent State Variables ---
-    static int selectedTowerIndex = -1;              // Currently selected tower index (-1 if none)
+    static TowerId selectedTower = INVALID_TOWER_ID;  // Currently selected tower (INVALID_TOWER_ID if none)
     static TowerType currentTowerType = TowerType::BASIC;  // Currently selected tower type (default BASIC)
-    static int playerMoney = 500;                      // Player's starting money
 
     // --- Update Tower Type Based on Keyboard Input ---
     if (IsKeyPressed(KEY_ONE)) { currentTowerType = TowerType::BASIC; }
     if (IsKeyPressed(KEY_TWO)) { currentTowerType = TowerType::SPLASH; }
     if (IsKeyPressed(KEY_THREE)) { currentTowerType = TowerType::SLOW; }
     if (IsKeyPressed(KEY_FOUR)) { currentTowerType = TowerType::SNIPER; }
+    if (IsKeyPressed(KEY_H)) { showCoverage = !showCoverage; }
+    if (IsKeyPressed(KEY_E)) { showEfficiency = !showEfficiency; }
+
+    // A sold tower disappears from the snapshot, which also clears the selection
+    const TowerView* selected = snapshot.findTower(selectedTower);
+    if (!selected) {
+        selectedTower = INVALID_TOWER_ID;
+    }
+
+    // Blend critters between the last two ticks by how far we are into the next one
+    renderAlpha = static_cast<float>((simulation.now() - snapshot.publishTime) * SimulationThread::ticksPerSecond);
+    renderAlpha = renderAlpha < 0.0f ? 0.0f : (renderAlpha > 1.0f ? 1.0f : renderAlpha);
 
     BeginDrawing();
     ClearBackground(RAYWHITE);
 
     // --- Draw the Map Grid ---
-    for (int y = 0; y < mapLogic.getHeight(); ++y) {
-        for (int x = 0; x < mapLogic.getWidth(); ++x) {
-            Color cellColor;
-            CellType cellType = mapLogic.getCell(x, y).type;
-            switch (cellType) {
-            case PATH:     cellColor = BLUE; break;
-            case SCENERY:  cellColor = LIGHTGRAY; break;
-            case ENTRY:    cellColor = GREEN; break;
-            case EXIT:     cellColor = RED; break;
-            default:       cellColor = DARKGRAY; break;
-            }
-            DrawRectangle(x * cellSize, y * cellSize, cellSize, cellSize, cellColor);
-            DrawRectangleLines(x * cellSize, y * cellSize, cellSize, cellSize, DARKGRAY);
-        }
+    drawMapGrid();
+
+    // --- Coverage Overlay: the selected tower's range, else the range of the type being placed ---
+    if (showCoverage) {
+        drawCoverageOverlay(selected ? selected->range : getArchetype(currentTowerType).range);
     }
 
     // --- Handle Tower Placement & Selection ---
@@ -438,186 +395,274 @@ void MapUI::drawUIWithTowersCustom(TowerManager& towerManager, TowerUIManager& t
 
             int gridX = mousePos.x / cellSize;
             int gridY = mousePos.y / cellSize;
-            const std::vector<Tower*>& towers = towerManager.getTowers();
-            bool towerClicked = false;
-            // Check if a tower was clicked.
-            for (size_t i = 0; i < towers.size(); i++) {
-                Vector2 towerPos = towers[i]->getPosition();
-                float dx = mousePos.x - towerPos.x;
-                float dy = mousePos.y - towerPos.y;
-                if (sqrt(dx * dx + dy * dy) < (cellSize / 3.0f)) {
-                    selectedTowerIndex = static_cast<int>(i);
-                    towerClicked = true;
-                    break;
-                }
+            // The snapshot's occupied cells answer both "was a tower clicked" and "is this cell free";
+            // the simulation re-checks the cell and the money before placing.
+            TowerId occupant = snapshot.towerAt(gridX, gridY);
+            if (occupant != INVALID_TOWER_ID) {
+                selectedTower = occupant;
             }
-            // If no tower was clicked, try to place a new tower.
-            if (!towerClicked) {
-                if (mapLogic.getCell(gridX, gridY).type == SCENERY) {
-                    bool cellOccupied = false;
-                    for (Tower* t : towers) {
-                        int tCellX = static_cast<int>(t->getPosition().x) / cellSize;
-                        int tCellY = static_cast<int>(t->getPosition().y) / cellSize;
-                        if (tCellX == gridX && tCellY == gridY) {
-                            cellOccupied = true;
-                            break;
-                        }
-                    }
-                    if (!cellOccupied) {
-                        Vector2 towerPos = { gridX * cellSize + cellSize / 2.0f,
-                                             gridY * cellSize + cellSize / 2.0f };
-                        Tower* newTower = nullptr;
-                        switch (currentTowerType) {
-                        case TowerType::BASIC: newTower = new BasicTower(); break;
-                        case TowerType::SPLASH: newTower = new SplashTower(); break;
-                        case TowerType::SLOW: newTower = new SlowTower(); break;
-                        case TowerType::SNIPER: newTower = new SniperTower(); break;
-                        default: newTower = new BasicTower(); break;
-                        }
-                        if (playerMoney >= newTower->getCost()) {
-                            playerMoney -= newTower->getCost();
-                            newTower->setPosition(towerPos);
-                            towerManager.addTower(newTower);
-                            selectedTowerIndex = -1;
-                        }
-                        else {
-                            delete newTower;
-                        }
-                    }
-                }
+            else if (mapLogic.getCellType(gridX, gridY) == SCENERY) {
+                SimCommand command = { SimCommandType::PLACE_TOWER, currentTowerType, gridX, gridY, INVALID_TOWER_ID, UpgradeType::POWER };
+                simulation.submit(command);
+                selectedTower = INVALID_TOWER_ID;
             }
         }
     }
 
     // --- Handle Tower Selling ---
-    if (IsKeyPressed(KEY_D) && selectedTowerIndex != -1) {
-        const std::vector<Tower*>& towers = towerManager.getTowers();
-        if (selectedTowerIndex < static_cast<int>(towers.size())) {
-            int sellValue = towers[selectedTowerIndex]->sell();
-            playerMoney += sellValue;
-            towerManager.removeTower(selectedTowerIndex);
-            selectedTowerIndex = -1;
-        }
+    if (IsKeyPressed(KEY_D) && selectedTower != INVALID_TOWER_ID) {
+        SimCommand command = { SimCommandType::SELL_TOWER, TowerType::BASIC, 0, 0, selectedTower, UpgradeType::POWER };
+        simulation.submit(command);
+        selectedTower = INVALID_TOWER_ID;
     }
 
     // --- Handle Tower Upgrading ---
-    if (IsKeyPressed(KEY_L) && selectedTowerIndex != -1) {
-        const std::vector<Tower*>& towers = towerManager.getTowers();
-        if (selectedTowerIndex < static_cast<int>(towers.size())) {
-            int upgradeCost = towers[selectedTowerIndex]->getCost();
-            if (playerMoney >= upgradeCost) {
-                towerManager.upgradeTower(selectedTowerIndex);
-                playerMoney -= upgradeCost;
-            }
-        }
+    bool upgradePressed = false;
+    UpgradeType upgradeType = UpgradeType::POWER;
+    if (IsKeyPressed(KEY_L)) { upgradePressed = true; upgradeType = UpgradeType::POWER; }
+    if (IsKeyPressed(KEY_R)) { upgradePressed = true; upgradeType = UpgradeType::RANGE; }
+    if (IsKeyPressed(KEY_F)) { upgradePressed = true; upgradeType = UpgradeType::FIRE_RATE; }
+    if (upgradePressed && selectedTower != INVALID_TOWER_ID) {
+        SimCommand command = { SimCommandType::UPGRADE_TOWER, TowerType::BASIC, 0, 0, selectedTower, upgradeType };
+        simulation.submit(command);
     }
 
-    // --- Update Tower Shooting with Critter Detection ---
-    // Now call the overloaded updateTowers with the CritterManager reference.
-    towerManager.Notify();
-
     // --- Draw Towers ---
-    towerUIManager.drawTowers(towerManager, cellSize);
+    towerUIManager.drawTowers(snapshot, cellSize);
 
     // --- Highlight Selected Tower ---
-    if (selectedTowerIndex != -1) {
-        const std::vector<Tower*>& towers = towerManager.getTowers();
-        if (selectedTowerIndex < static_cast<int>(towers.size())) {
-            Vector2 pos = towers[selectedTowerIndex]->getPosition();
-            DrawCircleLines(pos.x, pos.y, (cellSize / 3.0f) + 2, RED);
-        }
+    if (selected) {
+        DrawCircleLines(selected->position.x, selected->position.y, (cellSize / 3.0f) + 2, RED);
     }
 
-    // --- Draw UI Elements: Money & Level ---
-    std::string moneyText = "Money: " + std::to_string(playerMoney);
-    DrawText(moneyText.c_str(), 10, 10, 20, DARKGRAY);
-
+    // --- Draw UI Elements: Money, Wave, Legend and Tower Labels ---
+    HudState hud = { snapshot.money, snapshot.wave, snapshot.towerRevision,
+                     GetScreenWidth(), GetScreenHeight() };
+    drawHud(hud, snapshot);
 
-    // --- Draw the Legend (Right-Aligned) ---
-    const char* legendLines[] = {
-     "Tower Legend:",
-     "1 - Basic (Purple)",
-     "2 - Splash (Orange)",
-     "3 - Slow (Light Blue)",
-     "4 - Sniper (Dark Green)",
-     "L - Upgrade",
-     "D - Sell",
-     " ",
-     " ",
-     " ",
-     "Critter Legend: ",
-     "Tanky (Orange)",
-     "Speedy (Magenta)",
-     "Strong (Dark purple)"
-    };
-    Color legendColors[] = {
-        DARKGREEN,
-        PURPLE,
-        ORANGE,
-        SKYBLUE,
-        DARKGREEN,
-        BLACK,
-        BLACK,
-        BLACK,
-        BLACK,
-        BLACK,
-        DARKGREEN,
-        ORANGE,
-        MAGENTA,
-        DARKPURPLE
-        
-    };
-    int numLines = 14;
-    int fontSize = 20;
-    int spacing = 30;
-    int margin = 10;
-    int startY = 10;
-    DrawRightAlignedTextBlock(legendLines, legendColors, numLines, startY, spacing, fontSize, margin);
+    if (showEfficiency) {
+        drawEfficiencyOverlay(snapshot);
+    }
+}
 
+void MapUI::drawHud(const HudState& state, const RenderSnapshot& snapshot) {
+    bool resized = state.screenWidth != drawnHud.screenWidth || state.screenHeight != drawnHud.screenHeight;
+    bool stale = !hudValid || resized || state.money != drawnHud.money || state.wave != drawnHud.wave ||
+                 state.towerRevision != drawnHud.towerRevision;
+    if (stale) {
+        if (hudLayer.id == 0 || resized) {
+            if (hudLayer.id != 0) {
+                UnloadRenderTexture(hudLayer);
+            }
+            hudLayer = LoadRenderTexture(state.screenWidth, state.screenHeight);
+        }
+        BeginTextureMode(hudLayer);
+        ClearBackground(BLANK);
+
+        std::string moneyText = "Money: " + std::to_string(state.money);
+        DrawText(moneyText.c_str(), 10, 10, 20, DARKGRAY);
+        std::string levelText = "Wave: " + std::to_string(state.wave);
+        DrawText(levelText.c_str(), 10, 40, 20, DARKGRAY);
+
+        TowerUIManager::drawTowerLabels(snapshot, cellSize);
+
+        // --- Draw the Legend (Right-Aligned) ---
+        const char* legendLines[] = {
+         "Tower Legend:",
+         "1 - Basic (Purple)",
+         "2 - Splash (Orange)",
+         "3 - Slow (Light Blue)",
+         "4 - Sniper (Dark Green)",
+         "L - Upgrade Power",
+         "R - Upgrade Range",
+         "F - Upgrade Fire Rate",
+         "D - Sell",
+         "H - Coverage Map",
+         "E - Efficiency",
+         " ",
+         "Critter Legend: ",
+         "Tanky (Orange)",
+         "Speedy (Magenta)",
+         "Strong (Dark purple)"
+        };
+        Color legendColors[] = {
+            DARKGREEN,
+            PURPLE,
+            ORANGE,
+            SKYBLUE,
+            DARKGREEN,
+            BLACK,
+            BLACK,
+            BLACK,
+            BLACK,
+            BLACK,
+            BLACK,
+            BLACK,
+            DARKGREEN,
+            ORANGE,
+            MAGENTA,
+            DARKPURPLE
+        };
+        int numLines = 16;
+        int fontSize = 20;
+        int spacing = 30;
+        int margin = 10;
+        int startY = 10;
+        DrawRightAlignedTextBlock(legendLines, legendColors, numLines, startY, spacing, fontSize, margin);
+        EndTextureMode();
+        drawnHud = state;
+        hudValid = true;
+    }
+    // Render textures are stored upside down, hence the negative source height
+    DrawTextureRec(hudLayer.texture, { 0, 0, (float)state.screenWidth, -(float)state.screenHeight }, { 0, 0 }, WHITE);
 }
 
+void MapUI::drawCoverageOverlay(int range) {
+    coverageMap.update(mapLogic, range);
+    int maxCoverage = coverageMap.getMaxCoverage(range);
+    if (maxCoverage == 0) {
+        return;
+    }
+    // Only the cells on screen; the map can be far larger than the window
+    int width = mapLogic.getWidth();
+    int visibleWidth = std::min(width, (GetScreenWidth() + cellSize - 1) / cellSize);
+    int visibleHeight = std::min(mapLogic.getHeight(), (GetScreenHeight() + cellSize - 1) / cellSize);
+    for (int y = 0; y < visibleHeight; ++y) {
+        for (int x = 0; x < visibleWidth; ++x) {
+            int count = coverageMap.getCoverage(range, x, y);
+            if (count > 0 && mapLogic.getCellType(x, y) == SCENERY) {
+                DrawRectangle(x * cellSize, y * cellSize, cellSize, cellSize,
+                              Fade(RED, 0.6f * count / maxCoverage));
+            }
+        }
+    }
 
+    // Exact count under the mouse
+    Vector2 mousePos = GetMousePosition();
+    int hoverX = static_cast<int>(mousePos.x) / cellSize;
+    int hoverY = static_cast<int>(mousePos.y) / cellSize;
+    if (mousePos.x >= 0 && mousePos.y >= 0 && hoverX < width && hoverY < mapLogic.getHeight() &&
+        mapLogic.getCellType(hoverX, hoverY) == SCENERY) {
+        const TextLayout& countText = uiTextCache().number(coverageMap.getCoverage(range, hoverX, hoverY), 20);
+        DrawText(countText.text.c_str(), hoverX * cellSize + 4, hoverY * cellSize + 4, 20, BLACK);
+    }
+}
 
+static int percentOf(long long part, long long whole) {
+    return whole > 0 ? static_cast<int>(part * 100 / whole) : 0;
+}
 
+void MapUI::drawEfficiencyOverlay(const RenderSnapshot& snapshot) {
+    TextCache& cache = uiTextCache();
+    // Under each tower: percent of shots wasted (red, left) and of damage lost to overkill (orange, right)
+    for (const TowerView& tower : snapshot.towers) {
+        int x = static_cast<int>(tower.position.x) - cellSize / 2;
+        int y = static_cast<int>(tower.position.y) + cellSize / 2 - 12;
+        DrawRectangle(x, y, cellSize, 12, Fade(BLACK, 0.6f));
+        const TextLayout& wasted = cache.number(percentOf(tower.counters.wastedShots, tower.counters.shots), 10);
+        DrawText(wasted.text.c_str(), x + 2, y + 1, 10, RED);
+        const TextLayout& overkill = cache.number(percentOf(tower.counters.overkill, tower.counters.damage), 10);
+        DrawText(overkill.text.c_str(), x + cellSize - overkill.width - 2, y + 1, 10, ORANGE);
+    }
 
+    // The summary only changes when a wave ends, so its lines are formatted once per wave
+    const WaveEfficiency& wave = snapshot.lastWave;
+    if (wave.wave == 0) {
+        return;
+    }
+    if (wave.wave != efficiencyWave) {
+        static const char* const typeNames[towerTypeCount] = { "Basic", "Splash", "Slow", "Sniper" };
+        TowerCounters total = wave.total();
+        efficiencyLines.clear();
+        efficiencyLines.push_back("Wave " + std::to_string(wave.wave) + ": " +
+                                  std::to_string(static_cast<long long>(wave.damagePerSecond())) + " dps, " +
+                                  std::to_string(total.kills) + " kills, " + std::to_string(wave.leaks) + " leaks");
+        efficiencyLines.push_back("Overkill " + std::to_string(percentOf(total.overkill, total.damage)) +
+                                  "%, wasted shots " + std::to_string(total.wastedShots) + "/" + std::to_string(total.shots));
+        for (int i = 0; i < towerTypeCount; i++) {
+            const TowerCounters& counters = wave.byType[i];
+            if (counters.shots == 0) {
+                continue;
+            }
+            efficiencyLines.push_back(std::string(typeNames[i]) + ": " + std::to_string(counters.damage) + " dmg, " +
+                                      std::to_string(percentOf(counters.overkill, counters.damage)) + "% overkill, " +
+                                      std::to_string(percentOf(counters.wastedShots, counters.shots)) + "% wasted");
+        }
+        efficiencyWave = wave.wave;
+    }
+    int lineHeight = 18;
+    int top = GetScreenHeight() - lineHeight * static_cast<int>(efficiencyLines.size()) - 10;
+    int width = 0;
+    for (const std::string& line : efficiencyLines) {
+        int lineWidth = cache.measure(line, 16);
+        width = lineWidth > width ? lineWidth : width;
+    }
+    DrawRectangle(5, top - 5, width + 10, lineHeight * static_cast<int>(efficiencyLines.size()) + 10, Fade(RAYWHITE, 0.85f));
+    for (size_t i = 0; i < efficiencyLines.size(); i++) {
+        DrawText(efficiencyLines[i].c_str(), 10, top + static_cast<int>(i) * lineHeight, 16, DARKGRAY);
+    }
+}
 
 // Critter Drawing
-void MapUI::drawCritters(CritterManager &manager)
+void MapUI::drawCritters(const RenderSnapshot& snapshot)
 {
-    std::string levelText = "Wave: " + std::to_string(manager.getCurrentWave());
-    DrawText(levelText.c_str(), 10, 40, 20, DARKGRAY);
+    // The simulation thread spawns, moves and removes critters; this only draws the snapshot
+    for (const CritterView& critter : snapshot.critters)
+    {
+        Vector2 position = {
+            critter.previous.x + (critter.current.x - critter.previous.x) * renderAlpha,
+            critter.previous.y + (critter.current.y - critter.previous.y) * renderAlpha
+        };
+        drawCritter(critter.type, position, critter.healthFraction, critter.swarmSize);
+    }
 
-    //if (manager.getCritters().empty() && manager.getCrittersSpawned() >= numCritters)
-    //{
-    //    manager.resetWave();
-    //}
+    EndDrawing();
+}
 
-    manager.update(mapLogic); // Spawns critters at regular intervals
+static Color cellColor(CellType type)
+{
+    switch (type) {
+    case PATH:     return BLUE;
+    case SCENERY:  return LIGHTGRAY;
+    case ENTRY:    return GREEN;
+    case EXIT:     return RED;
+    default:       return DARKGRAY;
+    }
+}
 
-    auto &critters = manager.getCritters();
-    for (auto it = critters.begin(); it != critters.end();)
+// Walks the map a chunk at a time: off-screen chunks are skipped and a uniform chunk
+// is one rectangle plus its grid lines instead of a rectangle per cell.
+void MapUI::drawMapGrid()
+{
+    int screenWidth = GetScreenWidth();
+    int screenHeight = GetScreenHeight();
+    mapLogic.forEachChunk([&](const MapChunkView& chunk)
     {
-
-        // Check if critter reached the exit
-        if (mapLogic.getCell((*it)->getX(), (*it)->getY()).type == EXIT)
+        int left = chunk.x * cellSize;
+        int top = chunk.y * cellSize;
+        int right = left + chunk.width * cellSize;
+        int bottom = top + chunk.height * cellSize;
+        if (left >= screenWidth || top >= screenHeight)
+            return;
+
+        if (chunk.uniform)
         {
-            auto critterIt = std::find(critters.begin(), critters.end(), *it);
-            if (mapLogic.getCell((*it)->getX(), (*it)->getY()).type == EXIT) 
+            DrawRectangle(left, top, right - left, bottom - top, cellColor(chunk.type));
+            for (int x = left; x <= right; x += cellSize)
+                DrawLine(x, top, x, bottom, DARKGRAY);
+            for (int y = top; y <= bottom; y += cellSize)
+                DrawLine(left, y, right, y, DARKGRAY);
+            return;
+        }
+        for (int y = chunk.y; y < chunk.y + chunk.height; ++y)
+        {
+            for (int x = chunk.x; x < chunk.x + chunk.width; ++x)
             {
-                CritterLogic* critterToRemove = *it;
-                it = critters.erase(it);
-                manager.removeCritter(critterToRemove);
-                continue;
+                DrawRectangle(x * cellSize, y * cellSize, cellSize, cellSize, cellColor(mapLogic.getCellType(x, y)));
+                DrawRectangleLines(x * cellSize, y * cellSize, cellSize, cellSize, DARKGRAY);
             }
         }
-
-        Vector2 position = {((float)(*it)->getX() +0.5)* cellSize, ((float)(*it)->getY() +0.5) * cellSize};
-        (*it)->render(position);
-
-        ++it;
-    }
-
-    EndDrawing();
+    });
 }
 
 const char *MapUI::tileTypeToString(CellType type)
@@ -637,27 +682,31 @@ const char *MapUI::tileTypeToString(CellType type)
     }
 }
 
-void MapUI::wrapText(const std::string &text, int x, int y, int maxWidth, int fontSize)
+const char* MapUI::brushToString(EditBrush brush)
 {
-    int currentX = x;
-    int currentY = y;
-    std::string currentLine = "";
-
-    for (char c : text)
+    switch (brush)
     {
-        currentLine += c;
-
-        if (MeasureText(currentLine.c_str(), fontSize) > maxWidth)
-        {
-            DrawText(currentLine.c_str(), currentX, currentY, fontSize, DARKGRAY);
-            currentY += fontSize + 2;
-            currentLine = c; // Start new line with the current character
-        }
+    case EditBrush::PENCIL:
+        return "Pencil";
+    case EditBrush::LINE:
+        return "Line";
+    case EditBrush::RECT:
+        return "Rect";
+    case EditBrush::FILL:
+        return "Fill";
+    default:
+        return "Unknown";
     }
+}
 
-    // Draw the last line
-    if (!currentLine.empty())
+void MapUI::wrapText(const std::string &text, int x, int y, int maxWidth, int fontSize)
+{
+    // Line breaks are computed once per message and reused every frame after that
+    const std::vector<std::string>& lines = uiTextCache().wrap(text, maxWidth, fontSize);
+    int currentY = y;
+    for (const std::string& line : lines)
     {
-        DrawText(currentLine.c_str(), currentX, currentY, fontSize, DARKGRAY);
+        DrawText(line.c_str(), x, currentY, fontSize, DARKGRAY);
+        currentY += fontSize + 2;
     }
 }
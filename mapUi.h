@@ -7,27 +7,71 @@
 #include "raylib.h"
 #include <string>
 #include "ObserverVec.h"
+#include "memoryTracker.h"
+#include "coverageMap.h"
+#include "simulationThread.h"
+
+// Editor brush shapes; see mapBrush.h
+enum class EditBrush {
+    PENCIL,  // Paints every cell the mouse drags over
+    LINE,    // Straight line from press to release
+    RECT,    // Filled rectangle from press to release
+    FILL     // Flood fill of the clicked region
+};
+
+// Everything the HUD layer shows; the layer is redrawn only when one of these changes.
+struct HudState {
+    int money;
+    int wave;
+    unsigned int towerRevision;
+    int screenWidth;
+    int screenHeight;
+};
 
 class MapUI: public ObserverVec {
 public:
     MapUI(MapLogic& mapLogic);
     ~MapUI();
     void initUI();
+    // Frees GPU resources and closes the window.
+    void closeUI();
     void updateUI();
+    // Commits a brush stroke still in progress, so the map is never left inside an edit transaction.
+    void finishStroke();
     void drawUI();
-    void drawUIWithTowersCustom(TowerManager& towerManager,TowerUIManager& towerUIManager, CritterManager& critterManager);
-    void drawCritters(CritterManager& manager);
+    // Draws one frame of the game from a snapshot and sends the player's actions to the simulation.
+    void drawUIWithTowersCustom(SimulationThread& simulation, const RenderSnapshot& snapshot, TowerUIManager& towerUIManager);
+    void drawCritters(const RenderSnapshot& snapshot);
+    int getCellSize() const;
     void Update();
 
 private:
     MapLogic& mapLogic;
     int cellSize;
     CellType selectedTile;
+    EditBrush brush;
+    // A stroke lasts from mouse press to release and is applied as one map edit transaction
+    bool stroking;
+    int strokeX, strokeY;  // Cell the stroke started on
+    int lastX, lastY;      // Last cell the pencil painted
     std::string validationMessage; // To display validation result
+    float renderAlpha; // Blend between the previous and current sim tick when drawing critters
+    CoverageMap coverageMap; // Path cells in reach of each cell, per tower range
+    bool showCoverage;
+    bool showEfficiency;
+    int efficiencyWave;                   // Wave the efficiency panel lines were built for
+    std::vector<std::string> efficiencyLines;
+    RenderTexture2D hudLayer; // Money, wave, legend and tower labels, kept between frames
+    HudState drawnHud;        // What hudLayer currently shows
+    bool hudValid;
 
     bool validateMap(); // Method to validate the map
-    void dfs(int x, int y, std::vector<std::vector<bool>>& visited); // DFS for path connectivity
+    void drawMapGrid(); // Draws every visible cell, a chunk at a time
+    void drawCoverageOverlay(int range); // Tints scenery cells by how much path a tower there would reach
+    void drawEfficiencyOverlay(const RenderSnapshot& snapshot); // Wasted shots and overkill per tower, last wave summary
+    void drawHud(const HudState& state, const RenderSnapshot& snapshot); // Redraws the HUD layer if stale, then blits it
     const char* tileTypeToString(CellType type); // Convert CellType to string
+    const char* brushToString(EditBrush brush);
     void wrapText(const std::string& text, int x, int y, int maxWidth, int fontSize); // Wrap text function
     MapLogic *observable;
 };
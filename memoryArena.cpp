@@ -0,0 +1,62 @@
+#include "memoryArena.h"
+#include <new>
+
+MemoryArena::MemoryArena(std::size_t blockSize) : blockSize(blockSize), cursor(nullptr), end(nullptr) {
+    for (std::size_t i = 0; i < classCount; i++) {
+        freeLists[i] = nullptr;
+    }
+}
+
+MemoryArena::~MemoryArena() {
+    release();
+}
+
+void* MemoryArena::allocate(std::size_t bytes) {
+    std::size_t sizeClass = bytes == 0 ? 0 : (bytes - 1) / granularity;
+    if (sizeClass >= classCount) {
+        return ::operator new(bytes);
+    }
+    if (freeLists[sizeClass]) {
+        FreeNode* node = freeLists[sizeClass];
+        freeLists[sizeClass] = node->next;
+        return node;
+    }
+    std::size_t rounded = (sizeClass + 1) * granularity;
+    if (cursor == nullptr || static_cast<std::size_t>(end - cursor) < rounded) {
+        // The tail of the old block is abandoned; it is at most one size class.
+        char* block = static_cast<char*>(::operator new(blockSize));
+        blocks.push_back(block);
+        cursor = block;
+        end = block + blockSize;
+    }
+    void* p = cursor;
+    cursor += rounded;
+    return p;
+}
+
+void MemoryArena::deallocate(void* p, std::size_t bytes) {
+    std::size_t sizeClass = bytes == 0 ? 0 : (bytes - 1) / granularity;
+    if (sizeClass >= classCount) {
+        ::operator delete(p);
+        return;
+    }
+    FreeNode* node = static_cast<FreeNode*>(p);
+    node->next = freeLists[sizeClass];
+    freeLists[sizeClass] = node;
+}
+
+void MemoryArena::release() {
+    for (char* block : blocks) {
+        ::operator delete(block);
+    }
+    blocks.clear();
+    cursor = nullptr;
+    end = nullptr;
+    for (std::size_t i = 0; i < classCount; i++) {
+        freeLists[i] = nullptr;
+    }
+}
+
+std::size_t MemoryArena::getReservedBytes() const {
+    return blocks.size() * blockSize;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef MEMORY_ARENA_H
+#define MEMORY_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+// Single-threaded pool for small tracked allocations. Small requests are rounded
+// up to a size class and recycled through per-class free lists carved out of
+// large blocks; anything bigger goes straight to the global heap.
+// One arena belongs to one thread, so nothing here takes a lock.
+class MemoryArena {
+public:
+    explicit MemoryArena(std::size_t blockSize = 64 * 1024);
+    ~MemoryArena();
+
+    void* allocate(std::size_t bytes);
+    void deallocate(void* p, std::size_t bytes);
+
+    // Returns every block at once. Only call when nothing allocated here is still in use.
+    void release();
+    std::size_t getReservedBytes() const;
+
+private:
+    static const std::size_t granularity = 16;
+    static const std::size_t classCount = 32;  // Size classes up to 512 bytes
+
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    FreeNode* freeLists[classCount];
+    std::vector<char*> blocks;
+    std::size_t blockSize;
+    char* cursor;
+    char* end;
+
+    MemoryArena(const MemoryArena&);
+    MemoryArena& operator=(const MemoryArena&);
+};
+
+#endif
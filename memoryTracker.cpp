@@ -0,0 +1,137 @@
+#include "memoryTracker.h"
+#include "memoryArena.h"
+#include <iomanip>
+
+std::atomic<std::size_t> MemoryTracker::allocations[MemoryTracker::subsystemCount];
+std::atomic<std::size_t> MemoryTracker::deallocations[MemoryTracker::subsystemCount];
+std::atomic<std::size_t> MemoryTracker::liveBytes[MemoryTracker::subsystemCount];
+std::atomic<std::size_t> MemoryTracker::peakBytes[MemoryTracker::subsystemCount];
+std::atomic<std::size_t> MemoryTracker::wavePeakBytes[MemoryTracker::subsystemCount];
+std::atomic<std::size_t> MemoryTracker::totalLiveBytes(0);
+std::atomic<std::size_t> MemoryTracker::totalPeakBytes(0);
+std::atomic<std::size_t> MemoryTracker::waveTotalPeakBytes(0);
+
+thread_local MemoryArena* MemoryTracker::threadArena = nullptr;
+
+std::mutex MemoryTracker::historyMutex;
+std::vector<WaveMemoryRecord> MemoryTracker::waveHistory;
+int MemoryTracker::currentWave = 1;
+
+void MemoryTracker::raisePeak(std::atomic<std::size_t>& peak, std::size_t value) {
+    std::size_t current = peak.load(std::memory_order_relaxed);
+    while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void MemoryTracker::recordAllocation(MemorySubsystem subsystem, std::size_t bytes) {
+    int i = static_cast<int>(subsystem);
+    allocations[i].fetch_add(1, std::memory_order_relaxed);
+    std::size_t live = liveBytes[i].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    std::size_t total = totalLiveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    raisePeak(peakBytes[i], live);
+    raisePeak(wavePeakBytes[i], live);
+    raisePeak(totalPeakBytes, total);
+    raisePeak(waveTotalPeakBytes, total);
+}
+
+void MemoryTracker::recordDeallocation(MemorySubsystem subsystem, std::size_t bytes) {
+    int i = static_cast<int>(subsystem);
+    deallocations[i].fetch_add(1, std::memory_order_relaxed);
+    liveBytes[i].fetch_sub(bytes, std::memory_order_relaxed);
+    totalLiveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void* MemoryTracker::allocate(MemorySubsystem subsystem, std::size_t bytes) {
+    recordAllocation(subsystem, bytes);
+    MemoryArena* arena = threadArena;
+    return arena ? arena->allocate(bytes) : ::operator new(bytes);
+}
+
+void MemoryTracker::deallocate(MemorySubsystem subsystem, void* p, std::size_t bytes) {
+    recordDeallocation(subsystem, bytes);
+    MemoryArena* arena = threadArena;
+    if (arena) {
+        arena->deallocate(p, bytes);
+    }
+    else {
+        ::operator delete(p);
+    }
+}
+
+void MemoryTracker::setThreadArena(MemoryArena* arena) {
+    threadArena = arena;
+}
+
+MemoryStats MemoryTracker::getStats(MemorySubsystem subsystem) {
+    int i = static_cast<int>(subsystem);
+    MemoryStats stats;
+    stats.allocations = allocations[i].load(std::memory_order_relaxed);
+    stats.deallocations = deallocations[i].load(std::memory_order_relaxed);
+    stats.liveBytes = liveBytes[i].load(std::memory_order_relaxed);
+    stats.peakBytes = peakBytes[i].load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::size_t MemoryTracker::getTotalLiveBytes() {
+    return totalLiveBytes.load(std::memory_order_relaxed);
+}
+
+std::size_t MemoryTracker::getTotalPeakBytes() {
+    return totalPeakBytes.load(std::memory_order_relaxed);
+}
+
+void MemoryTracker::beginWave(int wave) {
+    std::lock_guard<std::mutex> lock(historyMutex);
+    WaveMemoryRecord record;
+    record.wave = currentWave;
+    for (int i = 0; i < subsystemCount; i++) {
+        // The new wave starts from whatever is still live.
+        record.peakBytes[i] = wavePeakBytes[i].exchange(liveBytes[i].load(std::memory_order_relaxed));
+    }
+    record.totalPeakBytes = waveTotalPeakBytes.exchange(totalLiveBytes.load(std::memory_order_relaxed));
+    waveHistory.push_back(record);
+    currentWave = wave;
+}
+
+std::vector<WaveMemoryRecord> MemoryTracker::getWaveHistory() {
+    std::lock_guard<std::mutex> lock(historyMutex);
+    return waveHistory;
+}
+
+const char* MemoryTracker::subsystemToString(MemorySubsystem subsystem) {
+    switch (subsystem) {
+    case MemorySubsystem::MAP: return "Map";
+    case MemorySubsystem::CRITTERS: return "Critters";
+    case MemorySubsystem::TOWERS: return "Towers";
+    case MemorySubsystem::BULLETS: return "Bullets";
+    case MemorySubsystem::OBSERVERS: return "Observers";
+    case MemorySubsystem::UI: return "UI";
+    default: return "Unknown";
+    }
+}
+
+void MemoryTracker::report(std::ostream& out) {
+    out << "Memory report:\n";
+    out << std::left << std::setw(12) << "Subsystem" << std::right
+        << std::setw(12) << "Allocs" << std::setw(12) << "Frees"
+        << std::setw(14) << "Live bytes" << std::setw(14) << "Peak bytes" << "\n";
+    for (int i = 0; i < subsystemCount; i++) {
+        MemoryStats stats = getStats(static_cast<MemorySubsystem>(i));
+        out << std::left << std::setw(12) << subsystemToString(static_cast<MemorySubsystem>(i)) << std::right
+            << std::setw(12) << stats.allocations << std::setw(12) << stats.deallocations
+            << std::setw(14) << stats.liveBytes << std::setw(14) << stats.peakBytes << "\n";
+    }
+    out << "Total live: " << getTotalLiveBytes() << " bytes, peak: " << getTotalPeakBytes() << " bytes\n";
+
+    std::lock_guard<std::mutex> lock(historyMutex);
+    for (const WaveMemoryRecord& record : waveHistory) {
+        out << "Wave " << record.wave << " peak: " << record.totalPeakBytes << " bytes (";
+        for (int i = 0; i < subsystemCount; i++) {
+            out << subsystemToString(static_cast<MemorySubsystem>(i)) << " " << record.peakBytes[i];
+            if (i + 1 < subsystemCount) {
+                out << ", ";
+            }
+        }
+        out << ")\n";
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <vector>
+
+class MemoryArena;
+
+// Subsystems that heap memory is charged to
+enum class MemorySubsystem {
+    MAP,
+    CRITTERS,
+    TOWERS,
+    BULLETS,
+    OBSERVERS,
+    UI,
+    COUNT
+};
+
+// Snapshot of the counters of one subsystem
+struct MemoryStats {
+    std::size_t allocations;
+    std::size_t deallocations;
+    std::size_t liveBytes;
+    std::size_t peakBytes;
+};
+
+// Peak usage reached while a given wave was running
+struct WaveMemoryRecord {
+    int wave;
+    std::size_t peakBytes[static_cast<int>(MemorySubsystem::COUNT)];
+    std::size_t totalPeakBytes;
+};
+
+// Global allocation counters and byte totals tagged by subsystem.
+// All counters are lock-free so tracking can stay on in release builds.
+class MemoryTracker {
+public:
+    static void recordAllocation(MemorySubsystem subsystem, std::size_t bytes);
+    static void recordDeallocation(MemorySubsystem subsystem, std::size_t bytes);
+
+    // Records the allocation and serves it from this thread's arena, or the global heap if none is set.
+    static void* allocate(MemorySubsystem subsystem, std::size_t bytes);
+    static void deallocate(MemorySubsystem subsystem, void* p, std::size_t bytes);
+    // Routes this thread's tracked allocations to an arena; nullptr restores the global heap.
+    // Memory must be freed on the thread, and under the arena, it was allocated from.
+    static void setThreadArena(MemoryArena* arena);
+
+    static MemoryStats getStats(MemorySubsystem subsystem);
+    static std::size_t getTotalLiveBytes();
+    static std::size_t getTotalPeakBytes();
+
+    // Closes the peak record of the running wave and starts a new one.
+    static void beginWave(int wave);
+    static std::vector<WaveMemoryRecord> getWaveHistory();
+
+    // Prints live totals, all-time peaks and the per-wave peaks.
+    static void report(std::ostream& out);
+    static const char* subsystemToString(MemorySubsystem subsystem);
+
+private:
+    static const int subsystemCount = static_cast<int>(MemorySubsystem::COUNT);
+
+    static std::atomic<std::size_t> allocations[subsystemCount];
+    static std::atomic<std::size_t> deallocations[subsystemCount];
+    static std::atomic<std::size_t> liveBytes[subsystemCount];
+    static std::atomic<std::size_t> peakBytes[subsystemCount];
+    static std::atomic<std::size_t> wavePeakBytes[subsystemCount];
+    static std::atomic<std::size_t> totalLiveBytes;
+    static std::atomic<std::size_t> totalPeakBytes;
+    static std::atomic<std::size_t> waveTotalPeakBytes;
+
+    static thread_local MemoryArena* threadArena;
+
+    static std::mutex historyMutex;
+    static std::vector<WaveMemoryRecord> waveHistory;
+    static int currentWave;
+
+    static void raisePeak(std::atomic<std::size_t>& peak, std::size_t value);
+};
+
+// STL allocator that charges every allocation to a subsystem.
+template <class T, MemorySubsystem Subsystem>
+class TrackedAllocator {
+public:
+    typedef T value_type;
+
+    template <class U>
+    struct rebind {
+        typedef TrackedAllocator<U, Subsystem> other;
+    };
+
+    TrackedAllocator() noexcept {}
+    template <class U>
+    TrackedAllocator(const TrackedAllocator<U, Subsystem>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(MemoryTracker::allocate(Subsystem, n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        MemoryTracker::deallocate(Subsystem, p, n * sizeof(T));
+    }
+
+    template <class U>
+    bool operator==(const TrackedAllocator<U, Subsystem>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const TrackedAllocator<U, Subsystem>&) const noexcept { return false; }
+};
+
+// Base class that charges heap-allocated instances (and their subclasses) to a subsystem.
+// Relies on the virtual destructor of the derived hierarchy so the sized delete gets the real size.
+template <MemorySubsystem Subsystem>
+class TrackedObject {
+public:
+    static void* operator new(std::size_t size) {
+        return MemoryTracker::allocate(Subsystem, size);
+    }
+
+    static void operator delete(void* p, std::size_t size) noexcept {
+        MemoryTracker::deallocate(Subsystem, p, size);
+    }
+};
+
+#endif
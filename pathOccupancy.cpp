@@ -0,0 +1,67 @@
+#include "pathOccupancy.h"
+#include <algorithm>
+#include <cmath>
+
+PathOccupancy::PathOccupancy() : path(nullptr), mapVersion(0), version(0), width(0) {}
+
+void PathOccupancy::sync(MapLogic& mapLogic) {
+    const PathList& current = mapLogic.getPath();
+    if (path == &current && mapVersion == mapLogic.getVersion() && width == mapLogic.getWidth()) {
+        return;
+    }
+    path = &current;
+    mapVersion = mapLogic.getVersion();
+    width = mapLogic.getWidth();
+    version++;
+
+    indexByCell.clear();
+    indexByCell.reserve(current.size());
+    for (size_t i = 0; i < current.size(); i++) {
+        indexByCell.emplace(current[i].y * width + current[i].x, static_cast<int>(i));
+    }
+    crittersBefore.assign(current.size() + 1, 0);
+}
+
+bool PathOccupancy::isSynced() const { return path != nullptr; }
+unsigned int PathOccupancy::getVersion() const { return version; }
+
+int PathOccupancy::countBetween(int begin, int end) const {
+    return crittersBefore[end] - crittersBefore[begin];
+}
+
+void PathOccupancy::findRuns(Vector2 center, float radius, int cellSize, PathRunList& runs) const {
+    runs.clear();
+    if (!path) {
+        return;
+    }
+    // Visit the cells whose centres are close enough, then join their path indices into runs
+    float reach = radius + cellSize * 0.5f;
+    float reachSquared = reach * reach;
+    int minX = static_cast<int>(std::floor((center.x - reach) / cellSize));
+    int maxX = static_cast<int>(std::floor((center.x + reach) / cellSize));
+    int minY = static_cast<int>(std::floor((center.y - reach) / cellSize));
+    int maxY = static_cast<int>(std::floor((center.y + reach) / cellSize));
+    found.clear();
+    for (int y = minY; y <= maxY; y++) {
+        for (int x = minX; x <= maxX; x++) {
+            float dx = (x + 0.5f) * cellSize - center.x;
+            float dy = (y + 0.5f) * cellSize - center.y;
+            if (x < 0 || y < 0 || x >= width || dx * dx + dy * dy > reachSquared) {
+                continue;
+            }
+            auto it = indexByCell.find(y * width + x);
+            if (it != indexByCell.end()) {
+                found.push_back(it->second);
+            }
+        }
+    }
+    std::sort(found.begin(), found.end());
+    for (int index : found) {
+        if (!runs.empty() && runs.back().end == index) {
+            runs.back().end++;
+        }
+        else {
+            runs.push_back({ index, index + 1 });
+        }
+    }
+}
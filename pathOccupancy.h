@@ -0,0 +1,74 @@
+#pragma once
+#ifndef PATH_OCCUPANCY_H
+#define PATH_OCCUPANCY_H
+
+#include <unordered_map>
+#include <vector>
+#include "raylib.h"
+#include "mapLogic.h"
+#include "memoryTracker.h"
+
+// A stretch [begin, end) of path indices.
+struct PathRun {
+    int begin;
+    int end;
+};
+
+typedef std::vector<PathRun, TrackedAllocator<PathRun, MemorySubsystem::TOWERS>> PathRunList;
+
+// How many critters stand on each cell of the path, recounted once per tick. Kept as
+// prefix sums, so "is anyone on path cells i .. j" is one subtraction. Critters never
+// leave the path, so a tower only needs to watch the path cells inside its range.
+class PathOccupancy {
+public:
+    PathOccupancy();
+
+    // Re-indexes the path after the map changed. Cheap when it did not.
+    void sync(MapLogic& mapLogic);
+    // Counts critters by the path cell they stand on.
+    template <class CritterRange>
+    void rebuild(const CritterRange& critters);
+
+    // False until the first sync; callers then cannot rule any cell out.
+    bool isSynced() const;
+    // Bumped whenever the path was re-indexed, so cached runs can tell they are stale.
+    unsigned int getVersion() const;
+    // Critters counted on path indices [begin, end).
+    int countBetween(int begin, int end) const;
+    // Replaces runs with the path indices a critter could stand on while within radius
+    // pixels of center. A critter is drawn up to half a cell from the path cell it is on,
+    // so the test is widened by that much and never misses one.
+    void findRuns(Vector2 center, float radius, int cellSize, PathRunList& runs) const;
+
+private:
+    const PathList* path;
+    unsigned int mapVersion;
+    unsigned int version;
+    int width;
+    // Path index of every path cell, by y * width + x; sparse like the map itself
+    std::unordered_map<int, int> indexByCell;
+    // crittersBefore[i] = critters on path indices below i
+    std::vector<int, TrackedAllocator<int, MemorySubsystem::CRITTERS>> crittersBefore;
+    // Scratch for findRuns
+    mutable std::vector<int, TrackedAllocator<int, MemorySubsystem::TOWERS>> found;
+};
+
+template <class CritterRange>
+void PathOccupancy::rebuild(const CritterRange& critters) {
+    if (!path) {
+        return;
+    }
+    std::fill(crittersBefore.begin(), crittersBefore.end(), 0);
+    int cells = static_cast<int>(path->size());
+    for (auto critter : critters) {
+        int index = critter->getPathIndex();
+        if (index >= 0 && index < cells) {
+            crittersBefore[index + 1]++;
+        }
+    }
+    for (size_t i = 1; i < crittersBefore.size(); i++) {
+        crittersBefore[i] += crittersBefore[i - 1];
+    }
+}
+
+#endif
@@ -0,0 +1,81 @@
+#pragma once
+#ifndef RENDER_SNAPSHOT_H
+#define RENDER_SNAPSHOT_H
+
+#include <algorithm>
+#include <vector>
+#include "raylib.h"
+#include "critterLogic.h"
+#include "towerLogic.h"
+#include "efficiencyLog.h"
+
+// What the render thread needs to draw one tower.
+struct TowerView {
+    TowerId id;
+    TowerType type;
+    Vector2 position;
+    int level;
+    int range;  // In grid cells
+    TowerCounters counters;
+};
+
+// A map cell holding a tower.
+struct OccupiedCell {
+    int cell;  // y * mapWidth + x
+    TowerId tower;
+};
+
+struct BulletView {
+    Vector2 position;
+};
+
+struct CritterView {
+    CritterType type;
+    Vector2 previous;  // Position one tick before the snapshot
+    Vector2 current;
+    float healthFraction;
+    int swarmSize;  // Members drawn as this one glyph, 1 for a lone critter
+};
+
+// Immutable copy of the game state published by the simulation thread after every tick.
+// The render thread draws only from this and never touches live game objects.
+struct RenderSnapshot {
+    long long tick = 0;
+    double publishTime = 0.0;  // Seconds on the sim clock when this was published
+    int money = 0;
+    int wave = 0;
+    unsigned int towerRevision = 0;
+    WaveEfficiency lastWave = {};  // Last finished wave; wave 0 until one finishes
+
+    std::vector<TowerView> towers;
+    std::vector<BulletView> bullets;
+    std::vector<CritterView> critters;
+
+    // The cells holding towers, sorted by cell and copied from the map only when the towers
+    // changed. One entry per tower, so its size follows the towers rather than the map.
+    int mapWidth = 0;
+    int mapHeight = 0;
+    unsigned int occupancyRevision = ~0u;
+    std::vector<OccupiedCell> occupancy;
+
+    TowerId towerAt(int x, int y) const {
+        if (x < 0 || y < 0 || x >= mapWidth || y >= mapHeight) {
+            return INVALID_TOWER_ID;
+        }
+        int cell = y * mapWidth + x;
+        auto it = std::lower_bound(occupancy.begin(), occupancy.end(), cell,
+                                   [](const OccupiedCell& occupied, int value) { return occupied.cell < value; });
+        return it != occupancy.end() && it->cell == cell ? it->tower : INVALID_TOWER_ID;
+    }
+
+    const TowerView* findTower(TowerId id) const {
+        for (const TowerView& tower : towers) {
+            if (tower.id == id) {
+                return &tower;
+            }
+        }
+        return nullptr;
+    }
+};
+
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+#ifndef SIM_COMMAND_H
+#define SIM_COMMAND_H
+
+#include "towerLogic.h"
+
+enum class SimCommandType {
+    PLACE_TOWER,
+    UPGRADE_TOWER,
+    SELL_TOWER,
+    NONE           // Does nothing; fills the slot of an env that takes no action this step
+};
+
+// A player action sent from the UI to the simulation. The simulation checks money
+// and occupancy itself, so a command that is no longer valid is simply ignored.
+struct SimCommand {
+    SimCommandType type;
+    TowerType towerType;      // PLACE_TOWER
+    int cellX;                // PLACE_TOWER
+    int cellY;
+    TowerId tower;            // UPGRADE_TOWER, SELL_TOWER
+    UpgradeType upgradeType;  // UPGRADE_TOWER
+};
+
+#endif
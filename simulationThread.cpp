@@ -0,0 +1,185 @@
+#include "simulationThread.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+
+// How far the simulation may fall behind before it drops the backlog instead of racing to catch up
+static const int maxCatchUpTicks = 5;
+
+SimulationThread::SimulationThread(MapLogic& mapLogic, TowerManager& towerManager, CritterManager& critterManager,
+                                   int cellSize, int startingMoney)
+    : mapLogic(mapLogic), towerManager(towerManager), critterManager(critterManager),
+    cellSize(cellSize), money(startingMoney), tickCount(0), trace(nullptr), running(false) {}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+void SimulationThread::start() {
+    if (running.exchange(true)) {
+        return;
+    }
+    // Build the path here so the render thread never sees it being built
+    mapLogic.getPath();
+    thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop() {
+    running.store(false, std::memory_order_release);
+    if (thread.joinable()) {
+        thread.join();
+        efficiency.finish(towerManager);
+    }
+}
+
+bool SimulationThread::submit(const SimCommand& command) {
+    if (!commands.push(command)) {
+        LOG_WARN("Simulation command queue full, command dropped");
+        return false;
+    }
+    return true;
+}
+
+const RenderSnapshot& SimulationThread::latestSnapshot() {
+    return snapshots.read();
+}
+
+const EfficiencyLog& SimulationThread::getEfficiencyLog() const {
+    return efficiency;
+}
+
+void SimulationThread::setTrace(TraceWriter* trace) {
+    this->trace = trace;
+}
+
+double SimulationThread::now() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SimulationThread::run() {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration tickDuration =
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / ticksPerSecond));
+    Clock::time_point nextTick = Clock::now();
+    publish();
+
+    while (running.load(std::memory_order_acquire)) {
+        SimCommand command;
+        while (commands.pop(command)) {
+            applyCommand(command);
+        }
+        tick();
+        publish();
+
+        nextTick += tickDuration;
+        Clock::time_point current = Clock::now();
+        if (current - nextTick > tickDuration * maxCatchUpTicks) {
+            nextTick = current;
+        }
+        std::this_thread::sleep_until(nextTick);
+    }
+}
+
+void SimulationThread::applyCommand(const SimCommand& command) {
+    switch (command.type) {
+    case SimCommandType::PLACE_TOWER: {
+        int x = command.cellX;
+        int y = command.cellY;
+        if (x < 0 || y < 0 || x >= mapLogic.getWidth() || y >= mapLogic.getHeight() ||
+            mapLogic.getCellType(x, y) != SCENERY || mapLogic.getOccupant(x, y) != INVALID_TOWER_ID) {
+            return;
+        }
+        int cost = getArchetype(command.towerType).cost;
+        if (money < cost) {
+            return;
+        }
+        money -= cost;
+        Tower* tower = createTower(command.towerType);
+        tower->setPosition({ x * cellSize + cellSize / 2.0f, y * cellSize + cellSize / 2.0f });
+        mapLogic.setOccupant(x, y, towerManager.addTower(tower));
+        break;
+    }
+    case SimCommandType::UPGRADE_TOWER: {
+        Tower* tower = towerManager.getTower(command.tower);
+        if (tower && money >= tower->getCost()) {
+            money -= tower->getCost();
+            towerManager.upgradeTower(command.tower, command.upgradeType);
+        }
+        break;
+    }
+    case SimCommandType::SELL_TOWER: {
+        Tower* tower = towerManager.getTower(command.tower);
+        if (tower) {
+            Vector2 pos = tower->getPosition();
+            mapLogic.setOccupant(static_cast<int>(pos.x) / cellSize, static_cast<int>(pos.y) / cellSize, INVALID_TOWER_ID);
+            money += towerManager.sellTower(command.tower);
+        }
+        break;
+    }
+    case SimCommandType::NONE:
+        break;
+    }
+}
+
+// Same order as before the split: towers fire, critters spawn and move, leaks are removed.
+void SimulationThread::tick() {
+    towerManager.updateTowers(cellSize);
+    critterManager.update(mapLogic);
+    int leaked = critterManager.removeCrittersAtExit();
+    tickCount++;
+    efficiency.recordTick(towerManager, critterManager.getCurrentWave(), leaked);
+    if (trace) {
+        trace->record(tickCount, critterManager, towerManager, cellSize);
+    }
+}
+
+void SimulationThread::publish() {
+    RenderSnapshot& snapshot = snapshots.writeBuffer();
+    snapshot.tick = tickCount;
+    snapshot.money = money;
+    snapshot.wave = critterManager.getCurrentWave();
+    snapshot.towerRevision = towerManager.getRevision();
+    if (!efficiency.getWaves().empty()) {
+        snapshot.lastWave = efficiency.getWaves().back();
+    }
+
+    // The vectors keep their capacity between ticks, so steady state publishing does not allocate
+    snapshot.towers.clear();
+    snapshot.bullets.clear();
+    const TowerList& towers = towerManager.getTowers();
+    for (size_t i = 0; i < towers.size(); i++) {
+        const Tower* tower = towers[i];
+        TowerView view = { towerManager.getTowerIdAt(i), tower->getTowerType(), tower->getPosition(),
+                           tower->getLevel(), tower->getRange(), tower->getCounters() };
+        snapshot.towers.push_back(view);
+        for (const Bullet& bullet : tower->getBullets()) {
+            if (bullet.active) {
+                snapshot.bullets.push_back({ toVector2(bullet.position) });
+            }
+        }
+    }
+
+    snapshot.critters.clear();
+    for (const CritterLogic* critter : critterManager.getCritters()) {
+        CritterView view = { critter->getType(), critter->getRenderPosition(cellSize, 0.0f),
+                             toVector2(critter->getPosition(cellSize)), (float)critter->getHealth() / critter->getMaxHealth(),
+                             critter->getSwarmSize() };
+        snapshot.critters.push_back(view);
+    }
+
+    if (snapshot.occupancyRevision != snapshot.towerRevision ||
+        snapshot.mapWidth != mapLogic.getWidth() || snapshot.mapHeight != mapLogic.getHeight()) {
+        snapshot.mapWidth = mapLogic.getWidth();
+        snapshot.mapHeight = mapLogic.getHeight();
+        snapshot.occupancy.clear();
+        mapLogic.forEachOccupant([&snapshot](int x, int y, unsigned int occupant) {
+            snapshot.occupancy.push_back({ y * snapshot.mapWidth + x, occupant });
+        });
+        std::sort(snapshot.occupancy.begin(), snapshot.occupancy.end(),
+                  [](const OccupiedCell& a, const OccupiedCell& b) { return a.cell < b.cell; });
+        snapshot.occupancyRevision = snapshot.towerRevision;
+    }
+
+    snapshot.publishTime = now();
+    snapshots.publish();
+}
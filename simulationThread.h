@@ -0,0 +1,63 @@
+#pragma once
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+
+#include <atomic>
+#include <thread>
+#include "mapLogic.h"
+#include "critterLogic.h"
+#include "towerLogic.h"
+#include "renderSnapshot.h"
+#include "simCommand.h"
+#include "efficiencyLog.h"
+#include "traceWriter.h"
+#include "spscQueue.h"
+#include "tripleBuffer.h"
+
+// Runs the game at a fixed tick rate on its own thread. The UI talks to it only
+// through the command queue and reads it only through published snapshots, so a
+// slow frame never holds up the simulation and a heavy wave never blocks drawing.
+class SimulationThread {
+public:
+    static const int ticksPerSecond = 60;
+
+    SimulationThread(MapLogic& mapLogic, TowerManager& towerManager, CritterManager& critterManager,
+                     int cellSize, int startingMoney);
+    ~SimulationThread();
+
+    void start();
+    void stop();
+
+    // UI thread only. Returns false if the queue is full and the command was dropped.
+    bool submit(const SimCommand& command);
+    // UI thread only. The newest snapshot; valid until the next call.
+    const RenderSnapshot& latestSnapshot();
+    // Seconds on the clock used for RenderSnapshot::publishTime.
+    double now() const;
+    // Only once the thread is stopped; the running wave is closed by stop().
+    const EfficiencyLog& getEfficiencyLog() const;
+    // Before start only. Records every tick into trace; the caller owns it.
+    void setTrace(TraceWriter* trace);
+
+private:
+    MapLogic& mapLogic;
+    TowerManager& towerManager;
+    CritterManager& critterManager;
+    int cellSize;
+    int money;
+    long long tickCount;
+    EfficiencyLog efficiency;
+    TraceWriter* trace;
+
+    std::thread thread;
+    std::atomic<bool> running;
+    SpscQueue<SimCommand, 256> commands;
+    TripleBuffer<RenderSnapshot> snapshots;
+
+    void run();
+    void applyCommand(const SimCommand& command);
+    void tick();
+    void publish();
+};
+
+#endif
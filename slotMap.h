@@ -0,0 +1,125 @@
+#pragma once
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <vector>
+#include "memoryTracker.h"
+
+// Handle into a SlotMap: the slot index in the low bits and the slot's generation above it.
+// Generations start at 1, so 0 is never a live handle.
+typedef unsigned int SlotId;
+const SlotId INVALID_SLOT_ID = 0;
+
+// Values stored densely for fast iteration, addressed by handles that stay valid until
+// their value is erased. Insert, erase and lookup are O(1); erasing moves the last value
+// into the hole, so iteration order is not insertion order.
+template <class T, MemorySubsystem Subsystem>
+class SlotMap {
+public:
+    typedef std::vector<T, TrackedAllocator<T, Subsystem>> ValueList;
+
+    SlotId insert(const T& value);
+    // Returns false if the handle was already stale.
+    bool erase(SlotId id);
+    // Returns nullptr for stale or invalid handles.
+    T* get(SlotId id);
+    const T* get(SlotId id) const;
+    bool contains(SlotId id) const;
+    // Dense index of the value, -1 for stale or invalid handles.
+    int indexOf(SlotId id) const { return findDense(id); }
+
+    const ValueList& values() const { return dense; }
+    // Handle of the value at a dense index, for callers iterating values().
+    SlotId idAt(std::size_t denseIndex) const { return makeId(denseSlot[denseIndex]); }
+    std::size_t size() const { return dense.size(); }
+
+private:
+    static const unsigned int indexBits = 20;
+    static const unsigned int indexMask = (1u << indexBits) - 1;
+    static const unsigned int generationMask = (1u << (32 - indexBits)) - 1;
+
+    struct Slot {
+        int denseIndex;          // -1 while the slot is free
+        unsigned int generation;
+    };
+
+    ValueList dense;
+    std::vector<int, TrackedAllocator<int, Subsystem>> denseSlot;  // Slot of each dense value
+    std::vector<Slot, TrackedAllocator<Slot, Subsystem>> slots;
+    std::vector<int, TrackedAllocator<int, Subsystem>> freeSlots;
+
+    SlotId makeId(int slot) const { return (slots[slot].generation << indexBits) | static_cast<unsigned int>(slot); }
+    int findDense(SlotId id) const;
+};
+
+template <class T, MemorySubsystem Subsystem>
+SlotId SlotMap<T, Subsystem>::insert(const T& value) {
+    int slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else {
+        slot = static_cast<int>(slots.size());
+        Slot fresh = { -1, 1 };
+        slots.push_back(fresh);
+    }
+    slots[slot].denseIndex = static_cast<int>(dense.size());
+    dense.push_back(value);
+    denseSlot.push_back(slot);
+    return makeId(slot);
+}
+
+template <class T, MemorySubsystem Subsystem>
+int SlotMap<T, Subsystem>::findDense(SlotId id) const {
+    unsigned int slot = id & indexMask;
+    if (id == INVALID_SLOT_ID || slot >= slots.size() || slots[slot].generation != (id >> indexBits)) {
+        return -1;
+    }
+    return slots[slot].denseIndex;
+}
+
+template <class T, MemorySubsystem Subsystem>
+bool SlotMap<T, Subsystem>::erase(SlotId id) {
+    int index = findDense(id);
+    if (index < 0) {
+        return false;
+    }
+    int slot = static_cast<int>(id & indexMask);
+    int last = static_cast<int>(dense.size()) - 1;
+    if (index != last) {
+        dense[index] = dense[last];
+        denseSlot[index] = denseSlot[last];
+        slots[denseSlot[index]].denseIndex = index;
+    }
+    dense.pop_back();
+    denseSlot.pop_back();
+
+    // A new generation makes every outstanding handle to this slot stale
+    slots[slot].denseIndex = -1;
+    slots[slot].generation = (slots[slot].generation + 1) & generationMask;
+    if (slots[slot].generation == 0) {
+        slots[slot].generation = 1;
+    }
+    freeSlots.push_back(slot);
+    return true;
+}
+
+template <class T, MemorySubsystem Subsystem>
+T* SlotMap<T, Subsystem>::get(SlotId id) {
+    int index = findDense(id);
+    return index < 0 ? nullptr : &dense[index];
+}
+
+template <class T, MemorySubsystem Subsystem>
+const T* SlotMap<T, Subsystem>::get(SlotId id) const {
+    int index = findDense(id);
+    return index < 0 ? nullptr : &dense[index];
+}
+
+template <class T, MemorySubsystem Subsystem>
+bool SlotMap<T, Subsystem>::contains(SlotId id) const {
+    return findDense(id) >= 0;
+}
+
+#endif
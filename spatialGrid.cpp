@@ -0,0 +1,26 @@
+#include "spatialGrid.h"
+
+SpatialGrid::SpatialGrid() : width(0), height(0), chunksX(0), cellSize(1), orderedBuckets(0) {}
+
+void SpatialGrid::resize(int newWidth, int newHeight) {
+    if (newWidth == width && newHeight == height) {
+        return;
+    }
+    width = newWidth;
+    height = newHeight;
+    chunksX = (width + chunkSize - 1) / chunkSize;
+    int chunksY = (height + chunkSize - 1) / chunkSize;
+    chunkBlock.assign(static_cast<size_t>(chunksX) * chunksY, -1);
+    usedChunks.clear();
+}
+
+void SpatialGrid::reserve(std::size_t critterCount) {
+    items.reserve(critterCount);
+    critterCell.reserve(critterCount);
+    filledCells.reserve(critterCount);
+    critterPosition.reserve(critterCount);
+}
+
+int SpatialGrid::getWidth() const { return width; }
+int SpatialGrid::getHeight() const { return height; }
+int SpatialGrid::getCellSize() const { return cellSize; }
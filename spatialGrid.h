@@ -0,0 +1,234 @@
+#pragma once
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "raylib.h"
+#include "memoryTracker.h"
+#include "simScalar.h"
+
+class CritterLogic;
+
+// Uniform grid over the map that buckets critters by the cell they stand on.
+// Rebuilt once per tick with a counting sort, so radius queries only visit
+// the cells that overlap the query circle instead of every critter.
+// Cells are grouped in square chunks and only chunks with a critter in them get buckets,
+// so the grid costs memory per occupied chunk, not per map cell. When the critters are
+// few for their chunks, a rebuild only touches the buckets that hold one.
+class SpatialGrid {
+public:
+    SpatialGrid();
+
+    // Re-buckets all critters by their current pixel position.
+    // width and height are the map size in cells.
+    template <class CritterRange>
+    void rebuild(const CritterRange& critters, int width, int height, int cellSize);
+
+    // Calls visit(critter, distanceSquared) for every critter within radiusPixels of center.
+    // distanceSquared is a SimWide.
+    template <class Visitor>
+    void forEachInRadius(SimVec2 center, SimScalar radiusPixels, Visitor visit) const;
+
+    // Makes room for this many critters so rebuilds during the wave do not allocate.
+    void reserve(std::size_t critterCount);
+
+    int getWidth() const;
+    int getHeight() const;
+    int getCellSize() const;
+
+private:
+    static const int chunkSize = 32;
+    static const int chunkArea = chunkSize * chunkSize;
+
+    struct Entry {
+        CritterLogic* critter;
+        SimVec2 position;  // Cached at rebuild so queries do not re-derive it
+    };
+
+    int width;
+    int height;
+    int chunksX;
+    int cellSize;
+#ifdef SIM_FIXED_POINT
+    uint64_t cellReciprocal;  // 2^32 / cellSize, rounded up
+#endif
+    // Per chunk: its block of buckets for this rebuild, or -1 if no critter stands in it
+    std::vector<int, TrackedAllocator<int, MemorySubsystem::CRITTERS>> chunkBlock;
+    std::vector<int, TrackedAllocator<int, MemorySubsystem::CRITTERS>> usedChunks;  // In block order
+    // Bucket i is cell i % chunkArea of block i / chunkArea;
+    // cellStart[i] .. cellEnd[i] indexes the critters standing on it.
+    // Only the buckets in filledCells, or the first orderedBuckets, are non-zero.
+    std::vector<int, TrackedAllocator<int, MemorySubsystem::CRITTERS>> cellStart;
+    std::vector<int, TrackedAllocator<int, MemorySubsystem::CRITTERS>> cellEnd;
+    std::vector<int, TrackedAllocator<int, MemorySubsystem::CRITTERS>> filledCells;  // In order of first critter
+    size_t orderedBuckets;  // Buckets the last rebuild laid out in order, or 0 if it used filledCells
+    std::vector<Entry, TrackedAllocator<Entry, MemorySubsystem::CRITTERS>> items;
+    std::vector<int, TrackedAllocator<int, MemorySubsystem::CRITTERS>> critterCell;
+    std::vector<SimVec2, TrackedAllocator<SimVec2, MemorySubsystem::CRITTERS>> critterPosition;
+
+    void resize(int width, int height);
+    // Bucket of a cell inside the map, or -1 if nothing stands in its chunk.
+    int bucketOf(int x, int y) const;
+    // Column or row of a pixel coordinate; negative left of or above the map.
+    int cellOf(SimScalar pixels) const;
+};
+
+inline int SpatialGrid::bucketOf(int x, int y) const {
+    int block = chunkBlock[(y / chunkSize) * chunksX + x / chunkSize];
+    return block < 0 ? -1 : block * chunkArea + (y % chunkSize) * chunkSize + x % chunkSize;
+}
+
+inline int SpatialGrid::cellOf(SimScalar pixels) const {
+#ifdef SIM_FIXED_POINT
+    // Multiplying by the rounded-up reciprocal instead of dividing is exact for every
+    // whole pixel below 2^19, and the whole pixel gives the same cell as the exact one
+    int whole = simToInt(pixels);
+    return whole < 0 ? -1 : static_cast<int>((static_cast<uint64_t>(whole) * cellReciprocal) >> 32);
+#else
+    return static_cast<int>(pixels / cellSize);
+#endif
+}
+
+template <class CritterRange>
+void SpatialGrid::rebuild(const CritterRange& critters, int newWidth, int newHeight, int newCellSize) {
+    resize(newWidth, newHeight);
+    cellSize = newCellSize;
+#ifdef SIM_FIXED_POINT
+    cellReciprocal = ((uint64_t(1) << 32) + cellSize - 1) / cellSize;
+#endif
+    for (int chunk : usedChunks) {
+        chunkBlock[chunk] = -1;
+    }
+    usedChunks.clear();
+    if (orderedBuckets > 0) {
+        std::fill(cellStart.begin(), cellStart.begin() + orderedBuckets + 1, 0);
+        std::fill(cellEnd.begin(), cellEnd.begin() + orderedBuckets, 0);
+    }
+    else {
+        for (int cell : filledCells) {
+            cellStart[cell] = 0;
+            cellEnd[cell] = 0;
+        }
+    }
+    filledCells.clear();
+
+    // Give every chunk a critter stands in a block.
+    // Buckets are only grown, so once the critters have been everywhere rebuilds stop allocating.
+    critterCell.resize(critters.size());
+    critterPosition.resize(critters.size());
+    size_t index = 0;
+    for (auto critter : critters) {
+        SimVec2 position = critter->getPosition(cellSize);
+        int x = cellOf(position.x);
+        int y = cellOf(position.y);
+        int cell = -1;
+        if (x >= 0 && x < width && y >= 0 && y < height) {
+            int chunk = (y / chunkSize) * chunksX + x / chunkSize;
+            if (chunkBlock[chunk] < 0) {
+                chunkBlock[chunk] = static_cast<int>(usedChunks.size());
+                usedChunks.push_back(chunk);
+            }
+            cell = bucketOf(x, y);
+        }
+        critterCell[index] = cell;
+        critterPosition[index++] = position;
+    }
+    size_t buckets = usedChunks.size() * chunkArea;
+    if (cellEnd.size() < buckets) {
+        cellStart.resize(buckets + 1, 0);
+        cellEnd.resize(buckets, 0);
+    }
+
+    // Count critters per bucket, then lay the filled buckets out one after another;
+    // cellEnd counts back up while filling. With a critter for every 16 buckets or more,
+    // walking and clearing all of them in order is cheaper than jumping between the
+    // filled ones, and keeps neighbouring cells together in items.
+    int count = 0;
+    orderedBuckets = critterCell.size() * 16 >= buckets ? buckets : 0;
+    if (orderedBuckets > 0) {
+        for (int cell : critterCell) {
+            if (cell >= 0) {
+                cellStart[cell + 1]++;
+            }
+        }
+        for (size_t cell = 1; cell <= buckets; cell++) {
+            cellStart[cell] += cellStart[cell - 1];
+        }
+        count = cellStart[buckets];
+        std::copy(cellStart.begin(), cellStart.begin() + buckets, cellEnd.begin());
+    }
+    else {
+        for (int cell : critterCell) {
+            if (cell >= 0 && cellEnd[cell]++ == 0) {
+                filledCells.push_back(cell);
+            }
+        }
+        for (int cell : filledCells) {
+            cellStart[cell] = count;
+            count += cellEnd[cell];
+            cellEnd[cell] = cellStart[cell];
+        }
+    }
+    items.resize(count);
+    index = 0;
+    for (auto critter : critters) {
+        int cell = critterCell[index];
+        if (cell >= 0) {
+            Entry& entry = items[cellEnd[cell]++];
+            entry.critter = critter;
+            entry.position = critterPosition[index];
+        }
+        index++;
+    }
+}
+
+template <class Visitor>
+void SpatialGrid::forEachInRadius(SimVec2 center, SimScalar radiusPixels, Visitor visit) const {
+    if (width == 0 || height == 0) {
+        return;
+    }
+    int minX = cellOf(center.x - radiusPixels);
+    int maxX = cellOf(center.x + radiusPixels);
+    int minY = cellOf(center.y - radiusPixels);
+    int maxY = cellOf(center.y + radiusPixels);
+    minX = minX < 0 ? 0 : minX;
+    minY = minY < 0 ? 0 : minY;
+    maxX = maxX >= width ? width - 1 : maxX;
+    maxY = maxY >= height ? height - 1 : maxY;
+
+    SimWide radiusSquared = SimWide(radiusPixels) * radiusPixels;
+    for (int y = minY; y <= maxY; y++) {
+        // Distance from the centre to the nearest edge of this row of cells
+        SimScalar top = simFromInt(y * cellSize);
+        SimScalar bottom = simFromInt(y * cellSize + cellSize);
+        SimScalar nearY = center.y < top ? top : (center.y > bottom ? bottom : center.y);
+        SimScalar rowDy = nearY - center.y;
+        for (int x = minX; x <= maxX; x++) {
+            SimScalar left = simFromInt(x * cellSize);
+            SimScalar right = simFromInt(x * cellSize + cellSize);
+            SimScalar nearX = center.x < left ? left : (center.x > right ? right : center.x);
+            SimScalar cellDx = nearX - center.x;
+            if (simLengthSquared(cellDx, rowDy) > radiusSquared) {
+                continue;
+            }
+            int cell = bucketOf(x, y);
+            if (cell < 0) {
+                continue;
+            }
+            // Laid out in order, a bucket ends where the next one starts, on the same cache line
+            int end = orderedBuckets > 0 ? cellStart[cell + 1] : cellEnd[cell];
+            for (int i = cellStart[cell]; i < end; i++) {
+                SimScalar dx = items[i].position.x - center.x;
+                SimScalar dy = items[i].position.y - center.y;
+                SimWide distanceSquared = simLengthSquared(dx, dy);
+                if (distanceSquared <= radiusSquared) {
+                    visit(items[i].critter, distanceSquared);
+                }
+            }
+        }
+    }
+}
+
+#endif
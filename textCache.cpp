@@ -0,0 +1,76 @@
+#include "textCache.h"
+#include "raylib.h"
+
+std::string TextCache::key(const std::string& text, int a, int b) {
+    return std::to_string(a) + "," + std::to_string(b) + ":" + text;
+}
+
+int TextCache::measure(const std::string& text, int fontSize) {
+    std::string k = key(text, fontSize, 0);
+    auto it = widths.find(k);
+    if (it != widths.end()) {
+        return it->second;
+    }
+    int width = MeasureText(text.c_str(), fontSize);
+    widths.emplace(k, width);
+    return width;
+}
+
+const TextLayout& TextCache::number(int value, int fontSize) {
+    long long k = (static_cast<long long>(value) << 16) | (fontSize & 0xFFFF);
+    auto it = numbers.find(k);
+    if (it != numbers.end()) {
+        return it->second;
+    }
+    TextLayout layout;
+    layout.text = std::to_string(value);
+    layout.width = MeasureText(layout.text.c_str(), fontSize);
+    return numbers.emplace(k, layout).first->second;
+}
+
+int TextCache::glyphWidth(unsigned char c, int fontSize) {
+    std::vector<int>& table = glyphWidths[fontSize];
+    if (table.empty()) {
+        table.assign(256, -1);
+    }
+    if (table[c] < 0) {
+        char glyph[2] = { static_cast<char>(c), '\0' };
+        table[c] = MeasureText(glyph, fontSize);
+    }
+    return table[c];
+}
+
+const std::vector<std::string>& TextCache::wrap(const std::string& text, int maxWidth, int fontSize) {
+    std::string k = key(text, maxWidth, fontSize);
+    auto it = wrapped.find(k);
+    if (it != wrapped.end()) {
+        return it->second;
+    }
+
+    // The default font puts fontSize / 10 pixels between glyphs, so a line's width
+    // grows by one glyph plus that spacing per character; no need to re-measure it.
+    int spacing = fontSize / 10;
+    std::vector<std::string> lines;
+    std::string currentLine;
+    int lineWidth = 0;
+    for (char c : text) {
+        int advance = glyphWidth(static_cast<unsigned char>(c), fontSize);
+        int newWidth = currentLine.empty() ? advance : lineWidth + spacing + advance;
+        if (!currentLine.empty() && newWidth > maxWidth) {
+            lines.push_back(currentLine);
+            currentLine.clear();
+            newWidth = advance;
+        }
+        currentLine += c;
+        lineWidth = newWidth;
+    }
+    if (!currentLine.empty()) {
+        lines.push_back(currentLine);
+    }
+    return wrapped.emplace(k, lines).first->second;
+}
+
+TextCache& uiTextCache() {
+    static TextCache cache;
+    return cache;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A string with its measured width, laid out once.
+struct TextLayout {
+    std::string text;
+    int width;
+};
+
+// Remembers text measurements and layouts by content, so labels that do not change
+// are formatted and measured once instead of every frame. UI thread only.
+class TextCache {
+public:
+    // Width of text at fontSize; MeasureText runs once per distinct string and size.
+    int measure(const std::string& text, int fontSize);
+    // Decimal label for a number, formatted and measured once.
+    const TextLayout& number(int value, int fontSize);
+    // Breaks text into lines no wider than maxWidth, character by character.
+    // Runs in one pass over the text and is cached by text, width and size.
+    const std::vector<std::string>& wrap(const std::string& text, int maxWidth, int fontSize);
+
+private:
+    std::unordered_map<std::string, int> widths;
+    std::unordered_map<long long, TextLayout> numbers;
+    std::unordered_map<std::string, std::vector<std::string>> wrapped;
+    std::unordered_map<int, std::vector<int>> glyphWidths;  // Per font size, indexed by character
+
+    int glyphWidth(unsigned char c, int fontSize);
+    static std::string key(const std::string& text, int a, int b);
+};
+
+// Cache shared by everything drawing on the main window.
+TextCache& uiTextCache();
+
+#endif
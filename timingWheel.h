@@ -0,0 +1,149 @@
+#pragma once
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <cstdint>
+#include <vector>
+#include "memoryTracker.h"
+
+// Hierarchical timing wheel: entities register the tick they are next due, and advance()
+// hands back only the entries due on the new tick. Four levels of 256 slots cover any delay
+// up to 2^32 ticks; an entry starts on the finest level that reaches its tick and cascades down
+// a level each time the finer wheel wraps, so every entry is touched at most four times.
+// Entries cannot be cancelled; callers store handles and drop stale ones when they come due.
+template <MemorySubsystem Subsystem>
+class TimingWheel {
+public:
+    TimingWheel();
+
+    // Tick of the last advance(); starts at 0.
+    uint64_t getTick() const { return tick; }
+    // Number of entries waiting.
+    std::size_t size() const { return pending; }
+    // Makes room for this many waiting entries, so scheduling them does not allocate.
+    void reserve(std::size_t entries) { nodes.reserve(entries); }
+
+    // Registers payload to come due at dueTick. Ticks at or before the current one come due on the next advance.
+    void schedule(unsigned int payload, uint64_t dueTick);
+    // Moves to the next tick and calls onDue(payload) for every entry due on it.
+    template <class Callback>
+    void advance(Callback onDue);
+    // Drops every entry and restarts at tick 0.
+    void clear();
+
+private:
+    static const int levelBits = 8;
+    static const int levels = 4;
+    static const int slotsPerLevel = 1 << levelBits;
+    static const unsigned int slotMask = slotsPerLevel - 1;
+
+    struct Node {
+        uint64_t due;
+        unsigned int payload;
+        int next;  // Next node in the same slot or the free list, -1 ends it
+    };
+
+    uint64_t tick;
+    std::size_t pending;
+    // Nodes live in one pool linked into slots, so a steady schedule reuses them instead of allocating
+    std::vector<Node, TrackedAllocator<Node, Subsystem>> nodes;
+    int freeNode;
+    int slots[levels][slotsPerLevel];  // Head node of each slot, -1 when empty
+
+    void insert(int node);
+    void cascade(int level);
+};
+
+template <MemorySubsystem Subsystem>
+TimingWheel<Subsystem>::TimingWheel() : tick(0), pending(0), freeNode(-1) {
+    for (auto& level : slots) {
+        for (int& head : level) {
+            head = -1;
+        }
+    }
+}
+
+template <MemorySubsystem Subsystem>
+void TimingWheel<Subsystem>::schedule(unsigned int payload, uint64_t dueTick) {
+    int node = freeNode;
+    if (node >= 0) {
+        freeNode = nodes[node].next;
+    }
+    else {
+        node = static_cast<int>(nodes.size());
+        nodes.push_back(Node());
+    }
+    nodes[node].due = dueTick > tick ? dueTick : tick + 1;
+    nodes[node].payload = payload;
+    insert(node);
+    pending++;
+}
+
+// Picks the finest level whose span still reaches the due tick. A delay of 0 only happens
+// while cascading into the slot that is about to be drained.
+template <MemorySubsystem Subsystem>
+void TimingWheel<Subsystem>::insert(int node) {
+    uint64_t delay = nodes[node].due - tick;
+    int level = 0;
+    while (level < levels - 1 && delay >= (uint64_t(1) << (levelBits * (level + 1)))) {
+        level++;
+    }
+    int slot = static_cast<int>((nodes[node].due >> (levelBits * level)) & slotMask);
+    nodes[node].next = slots[level][slot];
+    slots[level][slot] = node;
+}
+
+// Re-inserts the entries of the current slot of a level; they now fit on a finer level.
+template <MemorySubsystem Subsystem>
+void TimingWheel<Subsystem>::cascade(int level) {
+    int slot = static_cast<int>((tick >> (levelBits * level)) & slotMask);
+    int node = slots[level][slot];
+    slots[level][slot] = -1;
+    while (node >= 0) {
+        int next = nodes[node].next;
+        insert(node);
+        node = next;
+    }
+}
+
+template <MemorySubsystem Subsystem>
+template <class Callback>
+void TimingWheel<Subsystem>::advance(Callback onDue) {
+    tick++;
+    // Each wrap of a level pulls the matching slot of the level above down, coarsest first
+    int wrapped = 0;
+    while (wrapped < levels - 1 && ((tick >> (levelBits * wrapped)) & slotMask) == 0) {
+        wrapped++;
+    }
+    for (int level = wrapped; level > 0; level--) {
+        cascade(level);
+    }
+
+    int slot = static_cast<int>(tick & slotMask);
+    int node = slots[0][slot];
+    slots[0][slot] = -1;
+    while (node >= 0) {
+        int next = nodes[node].next;
+        unsigned int payload = nodes[node].payload;
+        nodes[node].next = freeNode;
+        freeNode = node;
+        pending--;
+        onDue(payload);
+        node = next;
+    }
+}
+
+template <MemorySubsystem Subsystem>
+void TimingWheel<Subsystem>::clear() {
+    nodes.clear();
+    freeNode = -1;
+    pending = 0;
+    tick = 0;
+    for (auto& level : slots) {
+        for (int& head : level) {
+            head = -1;
+        }
+    }
+}
+
+#endif
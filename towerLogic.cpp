@@ -1,123 +1,306 @@
 #include "towerLogic.h"
+#include "logger.h"
 #include <cmath>
 #include <algorithm>
 
-// --------------------
-// TowerManager Static Member
-// --------------------
-CritterManager* TowerManager::critterManager;
-
 // ================== Tower Base Class Implementation ==================
 
-Tower::Tower(const std::string& name, int cost, int refundValue, int range, int power, float rateOfFire, TowerTargetingStrategy* strategy)
-    : name(name), level(1), cost(cost), refundValue(refundValue),
-    range(range), power(power), rateOfFire(rateOfFire), targetingStrategy(strategy),
-    cooldownTimer(0.0f) {
+Tower::Tower(TowerType type)
+    : type(type), name(getArchetype(type).name), targeting(getArchetype(type).targeting),
+    coolingDown(true), reachVersion(0), reachRange(0), reachCellSize(0), critterManager(nullptr), counters(),
+    targetId(-1), cooldownEnd(0) {
     position = { 0, 0 };
+    recomputeStats();
+}
+
+void Tower::recomputeStats() {
+    const TowerArchetype& archetype = getArchetype(type);
+    level = 1 + static_cast<int>(upgrades.size());
+    cost = archetype.cost;
+    refundValue = archetype.refundValue;
+    range = archetype.range;
+    power = archetype.power;
+    rateOfFire = archetype.rateOfFire;
+    for (UpgradeType upgradeType : upgrades) {
+        const StatModifier& modifier = getUpgradeModifier(upgradeType);
+        power += modifier.powerBonus;
+        range += modifier.rangeBonus;
+        rateOfFire += modifier.rateOfFireBonus;
+        refundValue += cost / 10;
+    }
+    // Count whole ticks the way a timer adding 1/60 s per tick would reach 1 / rateOfFire
+    SimScalar cooldownPeriod = simFromInt(1) / simFromFloat(rateOfFire);
+    SimScalar cooldownTimer = simRatio(1, 60);
+    cooldownTicks = 1;
+    while (cooldownTimer < cooldownPeriod) {
+        cooldownTimer += simRatio(1, 60);
+        cooldownTicks++;
+    }
+
+    // Room for every shot that can be in flight at this rate of fire (bullets live at most
+    // 300px of travel), so firing never grows the vector once the tower is placed or upgraded
+    float flightTicks = archetype.projectile == ProjectileMode::HITSCAN ? 0.0f : 300.0f / archetype.projectileSpeed;
+    bullets.reserve(static_cast<size_t>(flightTicks / 60.0f * rateOfFire) + 2);
 }
 
 Tower::~Tower() {}
 
 void Tower::Update() {
-    auto critters = TowerManager::critterManager->getCritters();
-    int cellSize = 40;
-    float towerRangePixels = getRange() * cellSize;
-    Vector2 towerPos = getPosition();
-
-    // Use targetingStrategy to find the appropriate target
-    CritterLogic* targetCritter = targetingStrategy->GetTargetCritter(critters, cellSize, towerRangePixels, towerPos);
-
-    // If a critter is in range and the tower is ready to shoot, fire a bullet.
-    if (targetCritter && readyToShoot()) {
-        Vector2 targetPos = {
-            targetCritter->getX() * (float)cellSize + cellSize / 2.0f,
-            targetCritter->getY() * (float)cellSize + cellSize / 2.0f
-        };
-        shootAt(targetPos);
-        resetCooldown();
+    const SpatialGrid& grid = critterManager->getSpatialGrid();
+    int cellSize = grid.getCellSize();
+
+    // Only look for a target when the tower can actually fire and a critter could be in range.
+    if (readyToShoot() && hasCritterInReach()) {
+        // The switch picks an inlined grid query for this tower's targeting mode
+        CritterLogic* targetCritter = selectTarget(targeting, grid, simFromInt(range * cellSize), position);
+        if (targetCritter) {
+            targetId = targetCritter->getId();
+            fireAt(targetCritter, cellSize);
+            resetCooldown();
+        }
     }
 
-    // Update bullets for this tower and check for collisions.
-    std::vector<Bullet>& bullets = const_cast<std::vector<Bullet>&>(getBullets());
-    for (Bullet& bullet : bullets) {
-        if (bullet.active) {
-            for (auto& critter : critters) {
-                Vector2 critterPos = {
-                    critter->getX() * (float)cellSize + cellSize / 2.0f,
-                    critter->getY() * (float)cellSize + cellSize / 2.0f
-                };
-                float dx = bullet.position.x - critterPos.x;
-                float dy = bullet.position.y - critterPos.y;
-                float distance = sqrt(dx * dx + dy * dy);
-                if (distance < 5.0f) { // collision threshold in pixels
-                    critter->minusHealth(bullet.damage);
-                    if (critter->isDead()) {
-                        TowerManager::critterManager->removeCritter(critter);
-                    }
-                    bullet.active = false;
-                }
-            }
+    // Every bullet knows its target, so there is no collision scan against other critters.
+    // Dead critters stay findable until TowerManager::updateTowers removes them.
+    updateBullets();
+}
+
+bool Tower::hasCritterInReach() {
+    const PathOccupancy& occupancy = critterManager->getPathOccupancy();
+    if (!occupancy.isSynced()) {
+        return true;
+    }
+    int cellSize = critterManager->getSpatialGrid().getCellSize();
+    if (reachVersion != occupancy.getVersion() || reachRange != range || reachCellSize != cellSize) {
+        occupancy.findRuns(getPosition(), range * (float)cellSize, cellSize, reach);
+        reachVersion = occupancy.getVersion();
+        reachRange = range;
+        reachCellSize = cellSize;
+    }
+    for (const PathRun& run : reach) {
+        if (occupancy.countBetween(run.begin, run.end) > 0) {
+            return true;
         }
     }
-    updateBullets();
+    return false;
+}
+
+void Tower::applyHit(const Bullet& bullet, CritterLogic* target, int cellSize) {
+    const HitEffect& effect = *bullet.effect;
+    // A direct hit strikes one member of a swarm; a splash catches every member on the cell
+    auto hitOne = [this, &bullet, &effect](CritterLogic* critter, bool area) {
+        int members = critter->getSwarmSize();
+        if (area) {
+            counters.damage += critter->takeAreaDamage(bullet.damage, &counters.overkill);
+        }
+        else {
+            counters.overkill += critter->minusHealth(bullet.damage);
+            counters.damage += bullet.damage;
+        }
+        counters.kills += members - critter->getSwarmSize();
+        if (effect.slowTicks > 0) {
+            critter->applySlow(effect.slowPercent, effect.slowTicks);
+        }
+        if (effect.dotTicks > 0) {
+            critter->applyDamageOverTime(effect.dotDamage, effect.dotTicks);
+        }
+    };
+
+    if (effect.splashRadius <= 0.0f) {
+        hitOne(target, false);
+        return;
+    }
+    SimVec2 impact = target->getPosition(cellSize);
+    critterManager->getSpatialGrid().forEachInRadius(impact, simFromFloat(effect.splashRadius) * cellSize,
+        [&hitOne](CritterLogic* critter, SimWide) {
+            if (!critter->isDead()) {
+                hitOne(critter, true);
+            }
+        });
 }
 
 void Tower::setPosition(Vector2 pos) {
-    position = pos;
+    position = { simFromFloat(pos.x), simFromFloat(pos.y) };
+    reachVersion = 0;
 }
 
 Vector2 Tower::getPosition() const {
-    return position;
+    return toVector2(position);
 }
 
 void Tower::upgrade() {
-    // Use PowerUpgradeDecorator for all towers.
-    PowerUpgradeDecorator temp(this, false); 
-    temp.upgrade();
+    upgrade(UpgradeType::POWER);
+}
+
+void Tower::upgrade(UpgradeType upgradeType) {
+    upgrades.push_back(upgradeType);
+    recomputeStats();
+    switch (upgradeType) {
+    case UpgradeType::POWER:
+        LOG_INFO("{} powered-up to level {} with increased damage!", name, level);
+        break;
+    case UpgradeType::RANGE:
+        LOG_INFO("{} upgraded to level {} with extended range!", name, level);
+        break;
+    case UpgradeType::FIRE_RATE:
+        LOG_INFO("{} upgraded to level {} with faster fire rate!", name, level);
+        break;
+    }
 }
 
 int Tower::sell() const {
     int sellValue = refundValue * level;
-    std::cout << name << " sold for " << sellValue << " coins.\n";
+    LOG_INFO("{} sold for {} coins.", name, sellValue);
     return sellValue;
 }
 
-std::string Tower::getName() const { return name; }
+const char* Tower::getName() const { return name; }
 int Tower::getLevel() const { return level; }
 int Tower::getCost() const { return cost; }
 int Tower::getRefundValue() const { return refundValue; }
 int Tower::getRange() const { return range; }
 int Tower::getPower() const { return power; }
 float Tower::getRateOfFire() const { return rateOfFire; }
+TargetingMode Tower::getTargetingMode() const { return targeting; }
+TowerType Tower::getTowerType() const { return type; }
+const std::vector<UpgradeType>& Tower::getUpgrades() const { return upgrades; }
+long long Tower::getDamageDealt() const { return counters.damage; }
+const TowerCounters& Tower::getCounters() const { return counters; }
+int Tower::getTargetId() const { return targetId; }
+void Tower::setCritterManager(CritterManager* manager) { critterManager = manager; }
 
 // ---------- Bullet Functionality Implementation ----------
 
-void Tower::shootAt(Vector2 target) {
+void Tower::fireAt(CritterLogic* target, int cellSize) {
+    const TowerArchetype& archetype = getArchetype(type);
     Bullet b;
     b.position = position;
-    Vector2 dir = { target.x - position.x, target.y - position.y };
-    float length = sqrt(dir.x * dir.x + dir.y * dir.y);
-    if (length != 0) {
-        dir.x /= length;
-        dir.y /= length;
+    b.velocity = { 0, 0 };
+    b.damage = power;
+    b.active = true;
+    b.effect = &archetype.effect;
+    b.mode = archetype.projectile;
+    b.targetId = target->getId();
+    b.ticksLeft = 0;
+    counters.shots++;
+
+    switch (archetype.projectile) {
+    case ProjectileMode::HITSCAN:
+        applyHit(b, target, cellSize);
+        return;
+
+    case ProjectileMode::HOMING:
+        // Give up after flying the old 300px bullet range
+        b.ticksLeft = simToInt(simFromInt(300) / simFromFloat(archetype.projectileSpeed));
+        break;
+
+    case ProjectileMode::INTERCEPT: {
+        // Solve |d + v t| = s t for the first time t the bullet can meet the critter,
+        // where d is the critter's offset from the tower and v its velocity.
+        SimScalar speed = simFromFloat(archetype.projectileSpeed);
+        SimVec2 targetPos = target->getPosition(cellSize);
+        SimVec2 ahead = target->predictPosition(simFromInt(1), cellSize);
+        SimVec2 d = { targetPos.x - position.x, targetPos.y - position.y };
+        SimVec2 v = { ahead.x - targetPos.x, ahead.y - targetPos.y };
+        // a, bq and c are squares of pixel offsets and the discriminant multiplies two of
+        // them; SimWide holds that comfortably for anything within tower range
+        SimWide a = simLengthSquared(v.x, v.y) - SimWide(speed) * speed;
+        SimWide bq = 2 * (SimWide(d.x) * v.x + SimWide(d.y) * v.y);
+        SimWide c = simLengthSquared(d.x, d.y);
+        SimWide t = SimWide(simSqrt(c)) / speed;
+        SimWide discriminant = bq * bq - 4 * a * c;
+        if (simAbs(a) > simFromFloat(1e-6f) && discriminant >= 0) {
+            SimWide root = simSqrt(discriminant);
+            SimWide t1 = (-bq - root) / (2 * a);
+            SimWide t2 = (-bq + root) / (2 * a);
+            SimWide best = t1 > 0 && (t1 < t2 || t2 <= 0) ? t1 : t2;
+            if (best > 0) {
+                t = best;
+            }
+        }
+        // Follow the path rather than the straight line in case the critter turns a corner
+        b.ticksLeft = simCeil(t);
+        if (b.ticksLeft < 1) {
+            b.ticksLeft = 1;
+        }
+        SimVec2 lead = target->predictPosition(simFromInt(b.ticksLeft), cellSize);
+        b.velocity = { (lead.x - position.x) / b.ticksLeft, (lead.y - position.y) / b.ticksLeft };
+        break;
     }
-    b.velocity = { dir.x * 5.0f, dir.y * 5.0f };
+    }
+    bullets.push_back(b);
+}
+
+void Tower::shootAt(Vector2 target) {
+    Bullet b;
+    b.position = position;
+    SimVec2 dir = { simFromFloat(target.x) - position.x, simFromFloat(target.y) - position.y };
+    SimScalar length = simSqrt(simLengthSquared(dir.x, dir.y));
+    SimScalar speed = simFromInt(5);
+    b.ticksLeft = length > 0 ? simCeil(length / speed) : 1;
+    b.velocity = { dir.x / b.ticksLeft, dir.y / b.ticksLeft };
     b.damage = power;
     b.active = true;
+    b.effect = &getArchetype(type).effect;
+    b.mode = ProjectileMode::INTERCEPT;
+    b.targetId = -1;
+    counters.shots++;
     bullets.push_back(b);
 }
 
 void Tower::updateBullets() {
-    cooldownTimer += 1.0f / 60.0f;
+    const CritterManager* critters = critterManager;
+    int cellSize = critters->getSpatialGrid().getCellSize();
+    SimScalar homingSpeed = simFromFloat(getArchetype(type).projectileSpeed);
+    SimWide homingSpeedSquared = SimWide(homingSpeed) * homingSpeed;
+
     for (auto& b : bullets) {
-        if (b.active) {
+        if (!b.active) {
+            continue;
+        }
+        CritterLogic* target = b.targetId >= 0 ? critters->findCritter(b.targetId) : nullptr;
+
+        if (b.mode == ProjectileMode::HOMING) {
+            if (!target || --b.ticksLeft < 0) {
+                b.active = false;  // Target died or left; the shot fizzles
+                counters.wastedShots++;
+                continue;
+            }
+            SimVec2 targetPos = target->getPosition(cellSize);
+            SimScalar dx = targetPos.x - b.position.x;
+            SimScalar dy = targetPos.y - b.position.y;
+            // Bullets that land this tick need no square root
+            SimWide distanceSquared = simLengthSquared(dx, dy);
+            if (distanceSquared <= homingSpeedSquared) {
+                applyHit(b, target, cellSize);
+                b.active = false;
+                continue;
+            }
+            SimScalar distance = simSqrt(distanceSquared);
+            b.velocity = { dx / distance * homingSpeed, dy / distance * homingSpeed };
             b.position.x += b.velocity.x;
             b.position.y += b.velocity.y;
-            float dx = b.position.x - position.x;
-            float dy = b.position.y - position.y;
-            if (sqrt(dx * dx + dy * dy) > 300) {
-                b.active = false;
+        }
+        else {
+            b.position.x += b.velocity.x;
+            b.position.y += b.velocity.y;
+            if (--b.ticksLeft > 0) {
+                continue;
+            }
+            // Arrived at the lead point: hit only if the target really is there
+            bool hit = false;
+            if (target) {
+                SimVec2 targetPos = target->getPosition(cellSize);
+                SimScalar dx = targetPos.x - b.position.x;
+                SimScalar dy = targetPos.y - b.position.y;
+                SimScalar hitRadius = simFromFloat(CRITTER_HIT_RADIUS);
+                hit = simLengthSquared(dx, dy) <= SimWide(hitRadius) * hitRadius;
+                if (hit) {
+                    applyHit(b, target, cellSize);
+                }
             }
+            counters.wastedShots += hit ? 0 : 1;
+            b.active = false;
         }
     }
     bullets.erase(std::remove_if(bullets.begin(), bullets.end(),
@@ -125,320 +308,255 @@ void Tower::updateBullets() {
 }
 
 bool Tower::readyToShoot() const {
-    return cooldownTimer >= (1.0f / rateOfFire);
+    return !coolingDown;
 }
 
 void Tower::resetCooldown() {
-    cooldownTimer = 0.0f;
+    coolingDown = true;
 }
 
-const std::vector<Bullet>& Tower::getBullets() const {
-    return bullets;
+void Tower::finishCooldown() {
+    coolingDown = false;
 }
 
-// ================== Derived Towers Implementation ==================
+int Tower::getCooldownTicks() const {
+    return cooldownTicks;
+}
 
-BasicTower::BasicTower() : Tower("Basic Tower", 100, 70, 3, 25, 1.0f, this) {}
+uint64_t Tower::getCooldownEnd() const {
+    return cooldownEnd;
+}
 
-void BasicTower::attack() {
-    float cooldownPeriod = 1.0f / getRateOfFire();
-    if (cooldownTimer >= cooldownPeriod) {
-        Vector2 target = { getPosition().x + 100, getPosition().y };
-        shootAt(target);
-        cooldownTimer = 0.0f;
-        std::cout << name << " attacks with direct damage, power: " << power << "\n";
-    }
+void Tower::setCooldownEnd(uint64_t tick) {
+    cooldownEnd = tick;
 }
 
-CritterLogic* BasicTower::GetTargetCritter(std::vector<CritterLogic*>& critters, int cellSize, int towerRangePixels, Vector2 towerPos) {
-    CritterLogic* targetCritter = nullptr;
-    float minDistance = towerRangePixels;
-    for (auto& critter : critters) {
-        Vector2 critterPos = {
-            critter->getX() * (float)cellSize + cellSize / 2.0f,
-            critter->getY() * (float)cellSize + cellSize / 2.0f
-        };
-        float dx = towerPos.x - critterPos.x;
-        float dy = towerPos.y - critterPos.y;
-        float distance = sqrt(dx * dx + dy * dy);
-        if (distance <= towerRangePixels && distance < minDistance) {
-            targetCritter = critter;
-            minDistance = distance;
-        }
-    }
-    return targetCritter;
+bool Tower::isIdle() const {
+    return coolingDown && bullets.empty();
 }
 
-TowerType BasicTower::getTowerType() const {
-    return TowerType::BASIC;
+const BulletList& Tower::getBullets() const {
+    return bullets;
 }
 
-SplashTower::SplashTower() : Tower("Splash Tower", 150, 100, 2, 20, 0.8f, this) {}
+void TowerCounters::add(const TowerCounters& other) {
+    damage += other.damage;
+    overkill += other.overkill;
+    shots += other.shots;
+    wastedShots += other.wastedShots;
+    kills += other.kills;
+}
 
-void SplashTower::attack() {
-    float cooldownPeriod = 1.0f / getRateOfFire();
-    if (cooldownTimer >= cooldownPeriod) {
+// ================== Derived Towers Implementation ==================
+
+BasicTower::BasicTower() : Tower(TowerType::BASIC) {}
+
+void BasicTower::attack() {
+    if (readyToShoot()) {
         Vector2 target = { getPosition().x + 100, getPosition().y };
         shootAt(target);
-        cooldownTimer = 0.0f;
-        std::cout << name << " attacks with splash damage, power: " << power << "\n";
+        resetCooldown();
+        LOG_DEBUG("{} attacks with direct damage, power: {}", name, power);
     }
 }
 
-CritterLogic* SplashTower::GetTargetCritter(std::vector<CritterLogic*>& critters, int cellSize, int towerRangePixels, Vector2 towerPos) {
-    CritterLogic* nearestCritter = nullptr;
-    float minDistanceToTower = towerRangePixels;
-    std::vector<CritterLogic*> crittersInRange;
-    for (auto& critter : critters) {
-        Vector2 critterPos = {
-            critter->getX() * (float)cellSize + cellSize / 2.0f,
-            critter->getY() * (float)cellSize + cellSize / 2.0f
-        };
-        float dx = towerPos.x - critterPos.x;
-        float dy = towerPos.y - critterPos.y;
-        float distance = sqrt(dx * dx + dy * dy);
-        if (distance <= towerRangePixels) {
-            crittersInRange.push_back(critter);
-            if (distance < minDistanceToTower) {
-                nearestCritter = critter;
-                minDistanceToTower = distance;
-            }
-        }
-    }
-    if (crittersInRange.size() == 1) {
-        return nearestCritter;
-    }
-    CritterLogic* closestToExit = nullptr;
-    int minDistanceToExit = INT_MAX;
-    for (auto& critter : crittersInRange) {
-        int distanceToExit = critter->getDistanceToExit();
-        if (distanceToExit < minDistanceToExit) {
-            closestToExit = critter;
-            minDistanceToExit = distanceToExit;
-        }
-    }
-    return closestToExit;
-}
+SplashTower::SplashTower() : Tower(TowerType::SPLASH) {}
 
-TowerType SplashTower::getTowerType() const {
-    return TowerType::SPLASH;
+void SplashTower::attack() {
+    if (readyToShoot()) {
+        Vector2 target = { getPosition().x + 100, getPosition().y };
+        shootAt(target);
+        resetCooldown();
+        LOG_DEBUG("{} attacks with splash damage, power: {}", name, power);
+    }
 }
 
-SlowTower::SlowTower() : Tower("Slow Tower", 120, 80, 3, 15, 1.2f, this) {}
+SlowTower::SlowTower() : Tower(TowerType::SLOW) {}
 
 void SlowTower::attack() {
-    float cooldownPeriod = 1.0f / getRateOfFire();
-    if (cooldownTimer >= cooldownPeriod) {
+    if (readyToShoot()) {
         Vector2 target = { getPosition().x + 100, getPosition().y };
         shootAt(target);
-        cooldownTimer = 0.0f;
-        std::cout << name << " attacks and slows enemies, power: " << power << "\n";
+        resetCooldown();
+        LOG_DEBUG("{} attacks and slows enemies, power: {}", name, power);
     }
 }
 
-CritterLogic* SlowTower::GetTargetCritter(std::vector<CritterLogic*>& critters, int cellSize, int towerRangePixels, Vector2 towerPos) {
-    CritterLogic* weakestCritter = nullptr;
-    float minHealth = std::numeric_limits<float>::max();
-    for (auto& critter : critters) {
-        Vector2 critterPos = {
-            critter->getX() * (float)cellSize + cellSize / 2.0f,
-            critter->getY() * (float)cellSize + cellSize / 2.0f
-        };
-        float dx = towerPos.x - critterPos.x;
-        float dy = towerPos.y - critterPos.y;
-        float distance = sqrt(dx * dx + dy * dy);
-        if (distance <= towerRangePixels) {
-            float critterHealth = critter->getHealth();
-            if (critterHealth < minHealth) {
-                weakestCritter = critter;
-                minHealth = critterHealth;
-            }
-        }
-    }
-    return weakestCritter;
-}
-
-TowerType SlowTower::getTowerType() const {
-    return TowerType::SLOW;
-}
-
-SniperTower::SniperTower() : Tower("Sniper Tower", 110, 70, 5, 20, 0.7f, this) {}
+SniperTower::SniperTower() : Tower(TowerType::SNIPER) {}
 
 void SniperTower::attack() {
-    float cooldownPeriod = 1.0f / getRateOfFire();
-    if (cooldownTimer >= cooldownPeriod) {
+    if (readyToShoot()) {
         Vector2 target = { getPosition().x + 100, getPosition().y };
         shootAt(target);
-        cooldownTimer = 0.0f;
-        std::cout << name << " attacks and slows enemies, power: " << power << "\n";
-    }
-}
-
-CritterLogic* SniperTower::GetTargetCritter(std::vector<CritterLogic*>& critters, int cellSize, int towerRangePixels, Vector2 towerPos) {
-    CritterLogic* strongestCritter = nullptr;
-    float maxHealth = std::numeric_limits<float>::lowest();
-    for (auto& critter : critters) {
-        Vector2 critterPos = {
-            critter->getX() * (float)cellSize + cellSize / 2.0f,
-            critter->getY() * (float)cellSize + cellSize / 2.0f
-        };
-        float dx = towerPos.x - critterPos.x;
-        float dy = towerPos.y - critterPos.y;
-        float distance = sqrt(dx * dx + dy * dy);
-        if (distance <= towerRangePixels) {
-            float critterHealth = critter->getHealth();
-            if (critterHealth > maxHealth) {
-                strongestCritter = critter;
-                maxHealth = critterHealth;
-            }
-        }
+        resetCooldown();
+        LOG_DEBUG("{} attacks and slows enemies, power: {}", name, power);
     }
-    return strongestCritter;
 }
 
-TowerType SniperTower::getTowerType() const {
-    return TowerType::SNIPER;
-}
-
-// ================== TowerDecorator Implementation ==================
-
-TowerDecorator::TowerDecorator(Tower* tower, bool takeOwnership)
-// We call the base constructor with values taken from the wrapped tower.
-    : Tower(tower->getName(), tower->getCost(), tower->getRefundValue(), tower->getRange(), tower->getPower(), tower->getRateOfFire(), nullptr),
-    decoratedTower(tower), ownsComponent(takeOwnership) {
-}
+// ================== TowerManager Implementation ==================
 
-TowerDecorator::~TowerDecorator() {
-    if (ownsComponent) {
-        delete decoratedTower;
+Tower* createTower(TowerType type) {
+    switch (type) {
+    case TowerType::SPLASH: return new SplashTower();
+    case TowerType::SLOW:   return new SlowTower();
+    case TowerType::SNIPER: return new SniperTower();
+    default:                return new BasicTower();
     }
 }
 
-void TowerDecorator::Update() {
-    decoratedTower->Update();
-}
+TowerManager::TowerManager(CritterManager* critterManager)
+    : critterManager(critterManager), revision(0), retiredCounters() {}
 
-void TowerDecorator::attack() {
-    decoratedTower->attack();
+TowerManager::~TowerManager() {
+    for (Tower* tower : towers.values()) {
+        delete tower;
+    }
 }
 
-TowerType TowerDecorator::getTowerType() const {
-    return decoratedTower->getTowerType();
+TowerId TowerManager::addTower(Tower* tower) {
+    tower->setCritterManager(critterManager);
+    LOG_INFO("{} added.", tower->getName());
+    revision++;
+    TowerId id = towers.insert(tower);
+    // A new tower starts on a full cooldown counted from the next tick
+    cooldowns.reserve(towers.size());
+    awakeTowers.reserve(towers.size());
+    tower->resetCooldown();
+    tower->setCooldownEnd(cooldowns.getTick() + 1 + tower->getCooldownTicks());
+    cooldowns.schedule(id, tower->getCooldownEnd());
+    return id;
+}
+
+void TowerManager::removeTower(TowerId id) {
+    Tower* tower = getTower(id);
+    if (!tower) {
+        LOG_WARN("Invalid tower id.");
+        return;
+    }
+    LOG_INFO("{} removed.", tower->getName());
+    revision++;
+    retire(tower);
+    towers.erase(id);
+    delete tower;
 }
 
-// The default behavior here is delegation. (This method will be overridden in concrete decorators.)
-void TowerDecorator::upgrade() {
-    decoratedTower->upgrade();
+Tower* TowerManager::getTower(TowerId id) const {
+    Tower* const* tower = towers.get(id);
+    return tower ? *tower : nullptr;
 }
 
-int TowerDecorator::sell() const {
-    return decoratedTower->sell();
+TowerId TowerManager::getTowerIdAt(std::size_t index) const {
+    return towers.idAt(index);
 }
 
-void TowerDecorator::setPosition(Vector2 pos) {
-    decoratedTower->setPosition(pos);
-}
+// Walks the awake towers directly instead of notifying through the observer list.
+void TowerManager::updateTowers(int cellSize) {
+    critterManager->rebuildSpatialGrid(cellSize);
 
-Vector2 TowerDecorator::getPosition() const {
-    return decoratedTower->getPosition();
-}
+    bool woke = false;
+    cooldowns.advance([this, &woke](unsigned int id) {
+        Tower* tower = getTower(id);
+        if (!tower) {
+            return;  // Sold or removed while cooling down
+        }
+        // A cooling tower is still listed only while its bullets fly
+        bool listed = !tower->getBullets().empty();
+        tower->finishCooldown();
+        if (!listed) {
+            awakeTowers.push_back(id);
+            woke = true;
+        }
+    });
+    // Update in tower order, so which tower gets a kill does not depend on when it woke
+    if (woke) {
+        std::sort(awakeTowers.begin(), awakeTowers.end(), [this](TowerId a, TowerId b) {
+            return towers.indexOf(a) < towers.indexOf(b);
+        });
+    }
 
-const std::vector<Bullet>& TowerDecorator::getBullets() const {
-    return decoratedTower->getBullets();
+    uint64_t tick = cooldowns.getTick();
+    size_t kept = 0;
+    for (size_t i = 0; i < awakeTowers.size(); i++) {
+        TowerId id = awakeTowers[i];
+        Tower* tower = getTower(id);
+        if (!tower) {
+            continue;
+        }
+        bool ready = tower->readyToShoot();
+        tower->Update();
+        if (ready && !tower->readyToShoot()) {
+            tower->setCooldownEnd(tick + tower->getCooldownTicks());
+            cooldowns.schedule(id, tower->getCooldownEnd());
+        }
+        if (!tower->isIdle()) {
+            awakeTowers[kept++] = id;
+        }
+    }
+    awakeTowers.resize(kept);
+    // Kills are deferred so splash hits never touch a deleted critter.
+    critterManager->removeDeadCritters();
 }
 
-// ================== Concrete Upgrade Decorators ==================
-
-// PowerUpgradeDecorator increases the tower's damage more aggressively.
-PowerUpgradeDecorator::PowerUpgradeDecorator(Tower* tower, bool takeOwnership)
-    : TowerDecorator(tower, takeOwnership) {
+void TowerManager::upgradeTower(TowerId id, UpgradeType upgradeType) {
+    Tower* tower = getTower(id);
+    if (!tower) {
+        LOG_WARN("Invalid tower id for upgrade.");
+        return;
+    }
+    tower->upgrade(upgradeType);
+    revision++;
 }
 
-void PowerUpgradeDecorator::upgrade() {
-    // Directly update the decorated tower's fields.
-    decoratedTower->level++;
-    decoratedTower->power += 10; // extra bonus to power
-    decoratedTower->range += 1;
-    decoratedTower->refundValue += decoratedTower->cost / 10;
-    std::cout << decoratedTower->name << " powered-up to level " << decoratedTower->level
-        << " with increased damage!\n";
+int TowerManager::sellTower(TowerId id) {
+    Tower* tower = getTower(id);
+    if (!tower) {
+        LOG_WARN("Invalid tower id for selling.");
+        return 0;
+    }
+    int sellValue = tower->sell();
+    revision++;
+    retire(tower);
+    towers.erase(id);
+    delete tower;
+    return sellValue;
 }
 
-// RangeUpgradeDecorator increases the tower's range more.
-RangeUpgradeDecorator::RangeUpgradeDecorator(Tower* tower, bool takeOwnership)
-    : TowerDecorator(tower, takeOwnership) {
+const TowerList& TowerManager::getTowers() const {
+    return towers.values();
 }
 
-void RangeUpgradeDecorator::upgrade() {
-    decoratedTower->level++;
-    decoratedTower->power += 5;
-    decoratedTower->range += 2; // extra bonus to range
-    decoratedTower->refundValue += decoratedTower->cost / 10;
-    std::cout << decoratedTower->name << " upgraded to level " << decoratedTower->level
-        << " with extended range!\n";
+void TowerManager::retire(const Tower* tower) {
+    retiredCounters[static_cast<int>(tower->getTowerType())].add(tower->getCounters());
 }
 
-// ================== TowerManager Implementation ==================
-
-TowerManager::TowerManager() {}
-
-TowerManager::~TowerManager() {
-    for (Tower* tower : towers) {
-        Detach(tower);
-        delete tower;
+void TowerManager::sumCountersByType(TowerCounters totals[towerTypeCount]) const {
+    for (int i = 0; i < towerTypeCount; i++) {
+        totals[i] = retiredCounters[i];
     }
-    towers.clear();
-}
-
-void TowerManager::addTower(Tower* tower) {
-    Attach(tower);
-    towers.push_back(tower);
-    std::cout << tower->getName() << " added.\n";
-}
-
-void TowerManager::removeTower(int index) {
-    if (index < 0 || index >= static_cast<int>(towers.size())) {
-        std::cout << "Invalid tower index.\n";
-        return;
+    for (const Tower* tower : towers.values()) {
+        totals[static_cast<int>(tower->getTowerType())].add(tower->getCounters());
     }
-    std::cout << towers[index]->getName() << " removed.\n";
-    Detach(towers[index]);
-    delete towers[index];
-    towers.erase(towers.begin() + index);
-}
-
-void TowerManager::updateTowers(int cellSize) {
-    Notify();
 }
 
-void TowerManager::upgradeTower(int index) {
-    if (index < 0 || index >= static_cast<int>(towers.size())) {
-        std::cout << "Invalid tower index for upgrade.\n";
-        return;
-    }
-    // Calling upgrade() now automatically uses the decorator logic.
-    towers[index]->upgrade();
+std::size_t TowerManager::getAwakeTowerCount() const {
+    return awakeTowers.size();
 }
 
-int TowerManager::sellTower(int index) {
-    if (index < 0 || index >= static_cast<int>(towers.size())) {
-        std::cout << "Invalid tower index for selling.\n";
+int TowerManager::getCooldownLeft(const Tower& tower) const {
+    if (tower.readyToShoot() || tower.getCooldownEnd() <= cooldowns.getTick()) {
         return 0;
     }
-    int sellValue = towers[index]->sell();
-    Detach(towers[index]);
-    delete towers[index];
-    towers.erase(towers.begin() + index);
-    return sellValue;
+    return static_cast<int>(tower.getCooldownEnd() - cooldowns.getTick());
 }
 
-const std::vector<Tower*>& TowerManager::getTowers() const {
-    return towers;
+unsigned int TowerManager::getRevision() const {
+    return revision;
 }
 
 void TowerManager::printTowers() const {
-    std::cout << "Tower Manager - Towers:\n";
-    for (size_t i = 0; i < towers.size(); i++) {
-        std::cout << i << ": " << towers[i]->getName() << " (Level " << towers[i]->getLevel() << ")\n";
+    LOG_INFO("Tower Manager - Towers:");
+    const TowerList& list = towers.values();
+    for (size_t i = 0; i < list.size(); i++) {
+        LOG_INFO("{}: {} (Level {})", static_cast<std::size_t>(towers.idAt(i)), list[i]->getName(), list[i]->getLevel());
     }
 }
@@ -7,6 +7,8 @@
 #include "raylib.h"  // For Vector2
 #include "critterLogic.h"
 #include "TowerTargetingStrategy.h"
+#include "slotMap.h"
+#include "timingWheel.h"
 
 // Enum to distinguish tower types
 enum class TowerType {
@@ -16,14 +18,113 @@ enum class TowerType {
     SNIPER
 };
 
+const int towerTypeCount = 4;
+
+// How a tower's shots travel to their target.
+enum class ProjectileMode {
+    HITSCAN,    // Resolves the instant the tower fires
+    HOMING,     // Tracks the target critter and hits on arrival
+    INTERCEPT   // Flies straight to a computed lead point and resolves there
+};
+
+// What a bullet does on impact besides its direct damage.
+struct HitEffect {
+    float splashRadius;  // In grid cells, 0 = single target
+    int slowPercent;     // Movement speed while slowed, 100 = no slow
+    int slowTicks;
+    int dotDamage;       // Damage per DOT_INTERVAL frames
+    int dotTicks;
+};
+
+// --------------------
+// Tower archetypes
+// --------------------
+// Base stats of every tower type, indexed by TowerType.
+struct TowerArchetype {
+    TowerType type;
+    const char* name;
+    int cost;
+    int refundValue;
+    int range;      // In grid cells
+    int power;
+    float rateOfFire;  // Shots per second
+    TargetingMode targeting;
+    HitEffect effect;
+    ProjectileMode projectile;
+    float projectileSpeed;  // Pixels per tick, unused for hitscan
+};
+
+constexpr TowerArchetype towerArchetypes[] = {
+    // type               name            cost refund range power rate  targeting                       splash slow%  slowT dot dotT   projectile                 speed
+    { TowerType::BASIC,  "Basic Tower",  100, 70,    3,    25,   1.0f, TargetingMode::NEAREST,         { 0.0f,  100,   0,    0,  0 },   ProjectileMode::INTERCEPT, 5.0f },
+    { TowerType::SPLASH, "Splash Tower", 150, 100,   2,    20,   0.8f, TargetingMode::CLOSEST_TO_EXIT, { 1.0f,  100,   0,    2,  120 }, ProjectileMode::INTERCEPT, 4.0f },
+    { TowerType::SLOW,   "Slow Tower",   120, 80,    3,    15,   1.2f, TargetingMode::WEAKEST,         { 0.0f,  50,    120,  0,  0 },   ProjectileMode::HOMING,    5.0f },
+    { TowerType::SNIPER, "Sniper Tower", 110, 70,    5,    20,   0.7f, TargetingMode::STRONGEST,       { 0.0f,  100,   0,    0,  0 },   ProjectileMode::HITSCAN,   0.0f },
+};
+
+constexpr const TowerArchetype& getArchetype(TowerType type) {
+    return towerArchetypes[static_cast<int>(type)];
+}
+
+// --------------------
+// Upgrade modifiers
+// --------------------
+enum class UpgradeType {
+    POWER,
+    RANGE,
+    FIRE_RATE
+};
+
+// Stat bonus granted by one upgrade, indexed by UpgradeType.
+struct StatModifier {
+    UpgradeType type;
+    int powerBonus;
+    int rangeBonus;     // In grid cells
+    float rateOfFireBonus;
+};
+
+constexpr StatModifier upgradeModifiers[] = {
+    // type                    power range rate
+    { UpgradeType::POWER,     10,   1,    0.0f },
+    { UpgradeType::RANGE,     5,    2,    0.0f },
+    { UpgradeType::FIRE_RATE, 0,    0,    0.25f },
+};
+
+constexpr const StatModifier& getUpgradeModifier(UpgradeType type) {
+    return upgradeModifiers[static_cast<int>(type)];
+}
+
+static_assert(getArchetype(TowerType::BASIC).type == TowerType::BASIC &&
+              getArchetype(TowerType::SPLASH).type == TowerType::SPLASH &&
+              getArchetype(TowerType::SLOW).type == TowerType::SLOW &&
+              getArchetype(TowerType::SNIPER).type == TowerType::SNIPER,
+              "towerArchetypes must be ordered by TowerType");
+
 // --------------------
 // Bullet structure
 // --------------------
 struct Bullet {
-    Vector2 position;
-    Vector2 velocity;
+    SimVec2 position;
+    SimVec2 velocity;
     int damage;
     bool active;
+    const HitEffect* effect;  // Points into the archetype table
+    ProjectileMode mode;
+    int targetId;   // Critter the bullet resolves against, -1 for none
+    int ticksLeft;  // Intercept: ticks until it reaches its lead point. Homing: remaining lifetime.
+};
+
+typedef std::vector<Bullet, TrackedAllocator<Bullet, MemorySubsystem::BULLETS>> BulletList;
+
+// What a tower's shots achieved, counted as they land.
+struct TowerCounters {
+    long long damage;    // Direct and splash damage dealt, overkill included. Damage over time is not attributed.
+    long long overkill;  // Part of damage that went past a critter's last hit point
+    int shots;
+    int wastedShots;     // Shots that expired or missed without hitting anything
+    int kills;           // Swarm members count one each
+
+    void add(const TowerCounters& other);
 };
 
 // --------------------
@@ -39,60 +140,97 @@ public:
     virtual int sell() const = 0;
     virtual void setPosition(Vector2 pos) = 0;
     virtual Vector2 getPosition() const = 0;
-    virtual const std::vector<Bullet>& getBullets() const = 0;
+    virtual const BulletList& getBullets() const = 0;
 };
 
 // --------------------
 // Tower Base Class
 // --------------------
-class Tower : public ITower, public ObserverVec {
+class Tower : public ITower, public ObserverVec, public TrackedObject<MemorySubsystem::TOWERS> {
 protected:
-    std::string name;
+    TowerType type;
+    const char* name;  // Points into the archetype table
+    // Upgrades applied so far, in order. Folded into the effective stats below.
+    std::vector<UpgradeType> upgrades;
+
+    // Effective stats: archetype base plus every modifier in upgrades
     int level;
     int cost;
     int refundValue;
     int range;      // In grid cells
     int power;
     float rateOfFire;  // Shots per second
-    Vector2 position;  // Tower position
-    std::vector<Bullet> bullets;
-    TowerTargetingStrategy* targetingStrategy;
-    // Cooldown timer (in seconds) to control rate of fire.
-    float cooldownTimer;
+    int cooldownTicks;  // Sim ticks from one shot until the next
+
+    SimVec2 position;  // Tower position
+    BulletList bullets;
+    TargetingMode targeting;
+    // Set from a shot until the owning TowerManager's timing wheel ends the cooldown.
+    bool coolingDown;
+    // Path cells a critter in range could stand on, cached until the range or the path changes
+    PathRunList reach;
+    unsigned int reachVersion;  // PathOccupancy version the runs were found for, 0 = never
+    int reachRange;
+    int reachCellSize;
+    // Critters this tower shoots at; set by the TowerManager that owns it.
+    CritterManager* critterManager;
+    TowerCounters counters;
+    int targetId;          // Critter fired at last, -1 before the first shot
+    uint64_t cooldownEnd;  // Wheel tick the running cooldown ends on, set by the owning TowerManager
+
+    // Recomputes the effective stats from the archetype and the upgrade stack.
+    void recomputeStats();
+    // False when no critter stands on any path cell in reach, so targeting can be skipped.
+    bool hasCritterInReach();
+    // Applies a bullet's damage and effects to the critter it hit (and its neighbours for splash).
+    void applyHit(const Bullet& bullet, CritterLogic* target, int cellSize);
 public:
-    Tower(const std::string& name, int cost, int refundValue, int range, int power, float rateOfFire, TowerTargetingStrategy* strategy);
+    // Builds a tower from its archetype stats.
+    explicit Tower(TowerType type);
     virtual ~Tower();
 
     // ITower interface implementations
     void Update() override;
     void setPosition(Vector2 pos) override;
-    Vector2 getPosition() const override;
+    Vector2 getPosition() const override final;
     virtual void attack() override = 0;
-    virtual TowerType getTowerType() const override = 0;
-    // Upgrade now uses a decorator internally.
+    virtual TowerType getTowerType() const override final;
+    // Applies a power upgrade.
     virtual void upgrade() override;
+    void upgrade(UpgradeType upgradeType);
     virtual int sell() const override;
 
     // Additional getters for common attributes
-    std::string getName() const;
+    const char* getName() const;
     int getLevel() const;
     int getCost() const;
     int getRefundValue() const;
     int getRange() const;
     int getPower() const;
     float getRateOfFire() const;
+    TargetingMode getTargetingMode() const;
+    long long getDamageDealt() const;
+    const TowerCounters& getCounters() const;
+    int getTargetId() const;
+    void setCritterManager(CritterManager* manager);
 
     // ---------- Bullet Functionality ----------
+    // Fires at a critter using this tower's projectile mode.
+    void fireAt(CritterLogic* target, int cellSize);
+    // Fires an untargeted bullet that flies to a point and expires there.
     void shootAt(Vector2 target);
     void updateBullets();
     bool readyToShoot() const;
+    // Starts a cooldown; the owner calls finishCooldown getCooldownTicks() ticks later.
     void resetCooldown();
-    const std::vector<Bullet>& getBullets() const override;
-
-    // Allow our decorators to access protected members.
-    friend class TowerDecorator;
-    friend class PowerUpgradeDecorator;
-    friend class RangeUpgradeDecorator;
+    void finishCooldown();
+    int getCooldownTicks() const;
+    uint64_t getCooldownEnd() const;
+    void setCooldownEnd(uint64_t tick);
+    // Nothing to do until the cooldown ends: not ready and no bullets in flight.
+    bool isIdle() const;
+    const BulletList& getBullets() const override final;
+    const std::vector<UpgradeType>& getUpgrades() const;
 };
 
 // --------------------
@@ -100,106 +238,88 @@ public:
 // --------------------
 
 // BasicTower targets the nearest critter to the tower.
-class BasicTower : public Tower, public TowerTargetingStrategy {
+class BasicTower : public Tower {
 public:
     BasicTower();
     virtual void attack() override;
-    CritterLogic* GetTargetCritter(std::vector<CritterLogic*>& critters, int cellSize, int towerRangePixels, Vector2 towerPos);
-    virtual TowerType getTowerType() const override;
 };
 
 // SplashTower targets the critter nearest to the exit.
-class SplashTower : public Tower, public TowerTargetingStrategy {
+class SplashTower : public Tower {
 public:
     SplashTower();
     virtual void attack() override;
-    CritterLogic* GetTargetCritter(std::vector<CritterLogic*>& critters, int cellSize, int towerRangePixels, Vector2 towerPos);
-    virtual TowerType getTowerType() const override;
 };
 
 // SlowTower targets the weakest (least health) critter.
-class SlowTower : public Tower, public TowerTargetingStrategy {
+class SlowTower : public Tower {
 public:
     SlowTower();
     virtual void attack() override;
-    CritterLogic* GetTargetCritter(std::vector<CritterLogic*>& critters, int cellSize, int towerRangePixels, Vector2 towerPos);
-    virtual TowerType getTowerType() const override;
 };
 
 // SniperTower targets the strongest (most health) critter.
-class SniperTower : public Tower, public TowerTargetingStrategy {
+class SniperTower : public Tower {
 public:
     SniperTower();
     virtual void attack() override;
-    CritterLogic* GetTargetCritter(std::vector<CritterLogic*>& critters, int cellSize, int towerRangePixels, Vector2 towerPos);
-    virtual TowerType getTowerType() const override;
 };
 
-// --------------------
-// TowerDecorator Class
-// --------------------
-class TowerDecorator : public Tower {
-protected:
-    // Decorated tower (the component being wrapped)
-    Tower* decoratedTower;
-    bool ownsComponent;
-public:
-    // The decorator takes a Tower pointer.
-    // If takeOwnership is true, the decorator will delete the tower in its destructor.
-    TowerDecorator(Tower* tower, bool takeOwnership = true);
-    virtual ~TowerDecorator();
-
-    // ITower interface delegation
-    void Update() override;
-    void attack() override;
-    TowerType getTowerType() const override;
-    virtual void upgrade() override;
-    int sell() const override;
-    void setPosition(Vector2 pos) override;
-    Vector2 getPosition() const override;
-    const std::vector<Bullet>& getBullets() const override;
-};
+// Creates the derived tower for a type.
+Tower* createTower(TowerType type);
 
 // --------------------
-// Concrete Upgrade Decorators
+// TowerManager Class
 // --------------------
-class PowerUpgradeDecorator : public TowerDecorator {
-public:
-    // When used for self-decoration, set takeOwnership to false.
-    PowerUpgradeDecorator(Tower* tower, bool takeOwnership = true);
-    void upgrade() override;
-};
+// Stable handle to a tower owned by a TowerManager; survives other towers being removed.
+typedef SlotId TowerId;
+const TowerId INVALID_TOWER_ID = INVALID_SLOT_ID;
 
-class RangeUpgradeDecorator : public TowerDecorator {
-public:
-    RangeUpgradeDecorator(Tower* tower, bool takeOwnership = true);
-    void upgrade() override;
-};
+typedef SlotMap<Tower*, MemorySubsystem::TOWERS>::ValueList TowerList;
 
-// --------------------
-// TowerManager Class
-// --------------------
+// Towers only need a tick while they can fire or have bullets in flight. The rest sit in a
+// timing wheel until their cooldown ends, so a tick costs the awake towers, not every tower.
 class TowerManager : public ObservableVec {
 private:
-    std::vector<Tower*> towers;
+    SlotMap<Tower*, MemorySubsystem::TOWERS> towers;
+    CritterManager* critterManager;
+    unsigned int revision;
+    TimingWheel<MemorySubsystem::TOWERS> cooldowns;
+    std::vector<TowerId, TrackedAllocator<TowerId, MemorySubsystem::TOWERS>> awakeTowers;
+    // Counters of towers sold or removed, by TowerType, so totals survive them
+    TowerCounters retiredCounters[towerTypeCount];
+
+    void retire(const Tower* tower);
 public:
-    static CritterManager* critterManager;
-    TowerManager();
+    // Towers added to this manager shoot at the critters of critterManager.
+    explicit TowerManager(CritterManager* critterManager);
     ~TowerManager();
 
-    // Add or remove towers
-    void addTower(Tower* tower);
-    void removeTower(int index);
+    // Add or remove towers. The manager owns added towers.
+    TowerId addTower(Tower* tower);
+    void removeTower(TowerId id);
+    // Returns nullptr once the tower was removed or sold.
+    Tower* getTower(TowerId id) const;
+    // Id of the tower at an index of getTowers().
+    TowerId getTowerIdAt(std::size_t index) const;
 
-    // Call attack and update bullets on all towers
+    // Ends the cooldowns due this tick, then updates the towers that are awake
     void updateTowers(int cellSize);
+    // Towers updated on the last tick.
+    std::size_t getAwakeTowerCount() const;
+    // Ticks until the tower can fire again, 0 if it can now.
+    int getCooldownLeft(const Tower& tower) const;
+    // Counters of every tower this manager ever held, summed by TowerType.
+    void sumCountersByType(TowerCounters totals[towerTypeCount]) const;
 
     // Upgrade or sell a specific tower
-    void upgradeTower(int index);
-    int sellTower(int index);
+    void upgradeTower(TowerId id, UpgradeType upgradeType = UpgradeType::POWER);
+    int sellTower(TowerId id);
 
-    // Getter to access the towers (for UI rendering)
-    const std::vector<Tower*>& getTowers() const;
+    // Getter to access the towers (for UI rendering). Order changes when towers are removed.
+    const TowerList& getTowers() const;
+    // Bumped whenever a tower is added, removed, upgraded or sold, so views can tell they are stale.
+    unsigned int getRevision() const;
 
     // Debug: print info about towers
     void printTowers() const;
@@ -2,22 +2,28 @@
 #define TOWER_UI_H
 
 #include "towerLogic.h"
+#include "renderSnapshot.h"
 #include "raylib.h"
 
-// UI class for drawing a single tower and its bullets.
+// UI class for drawing a single tower.
 class TowerUI {
 public:
     // Draw a tower using raylib drawing functions.
     // The parameter cellSize is used to scale the tower drawing.
-    static void drawTower(const Tower* tower, int cellSize);
+    static void drawTower(const TowerView& tower, int cellSize);
+    // Draw the level and range text of a tower. Kept apart from drawTower so the
+    // labels can be drawn into the HUD layer only when they change.
+    static void drawTowerLabels(const TowerView& tower, int cellSize);
 };
 
-// UI Manager class that draws all towers from a TowerManager.
+// UI Manager class that draws all towers of a render snapshot.
 class TowerUIManager {
 public:
-    // Draw all towers stored in the TowerManager.
+    // Draw all towers and bullets in the snapshot.
     // cellSize is passed along for scaling.
-    static void drawTowers(const TowerManager& towerManager, int cellSize);
+    static void drawTowers(const RenderSnapshot& snapshot, int cellSize);
+    // Draw the level and range labels of all towers.
+    static void drawTowerLabels(const RenderSnapshot& snapshot, int cellSize);
 };
 
 #endif // TOWER_UI_H
@@ -1,12 +1,13 @@
 ﻿#include "towerUI.h"
+#include "textCache.h"
 #include <string>
 
-// Draw a single tower and its bullets.
-void TowerUI::drawTower(const Tower* tower, int cellSize) {
-    Vector2 pos = tower->getPosition();
+// Draw a single tower.
+void TowerUI::drawTower(const TowerView& tower, int cellSize) {
+    Vector2 pos = tower.position;
     Color color;
     // Choose color based on tower type.
-    switch (tower->getTowerType()) {
+    switch (tower.type) {
     case TowerType::BASIC:   color = PURPLE; break;
     case TowerType::SPLASH:  color = ORANGE; break;
     case TowerType::SLOW:    color = SKYBLUE; break;
@@ -18,33 +19,42 @@ void TowerUI::drawTower(const Tower* tower, int cellSize) {
     float towerRadius = static_cast<float>(cellSize) / 3.0f;
     DrawCircleV(pos, towerRadius, color);
 
-    // Draw the tower's level in the center.
-    std::string levelStr = std::to_string(tower->getLevel());
-    int levelTextWidth = MeasureText(levelStr.c_str(), 16);
-    DrawText(levelStr.c_str(), pos.x - levelTextWidth / 2, pos.y - 8, 16, WHITE);
-
     // Draw the tower's range circle.
-    float rangeDisplayRadius = tower->getRange() * cellSize; // Range in pixels.
+    float rangeDisplayRadius = tower.range * cellSize; // Range in pixels.
     DrawCircleLines(pos.x, pos.y, rangeDisplayRadius, LIGHTGRAY);
+}
+
+// Draw the level and range labels of a tower. Labels come from the text cache, so
+// nothing is formatted or measured unless the number is new.
+void TowerUI::drawTowerLabels(const TowerView& tower, int cellSize) {
+    Vector2 pos = tower.position;
+    TextCache& cache = uiTextCache();
+
+    // Draw the tower's level in the center.
+    const TextLayout& level = cache.number(tower.level, 16);
+    DrawText(level.text.c_str(), pos.x - level.width / 2, pos.y - 8, 16, WHITE);
 
     // Draw the numeric range above the tower.
-    std::string rangeStr = std::to_string(tower->getRange());
-    int rangeTextWidth = MeasureText(rangeStr.c_str(), 14);
-    DrawText(rangeStr.c_str(), pos.x - rangeTextWidth / 2, pos.y - static_cast<int>(rangeDisplayRadius) - 20, 14, DARKGRAY);
+    float rangeDisplayRadius = tower.range * cellSize; // Range in pixels.
+    const TextLayout& range = cache.number(tower.range, 14);
+    DrawText(range.text.c_str(), pos.x - range.width / 2, pos.y - static_cast<int>(rangeDisplayRadius) - 20, 14, DARKGRAY);
+}
+
+// Draw all towers and their bullets.
+void TowerUIManager::drawTowers(const RenderSnapshot& snapshot, int cellSize) {
+    for (const TowerView& tower : snapshot.towers) {
+        TowerUI::drawTower(tower, cellSize);
+    }
 
     // --- Draw Bullets ---
-    const std::vector<Bullet>& bullets = tower->getBullets();
-    for (const Bullet& b : bullets) {
-        if (b.active) {
-            DrawCircleV(b.position, 3, YELLOW);
-        }
+    for (const BulletView& bullet : snapshot.bullets) {
+        DrawCircleV(bullet.position, 3, YELLOW);
     }
 }
 
-// Draw all towers.
-void TowerUIManager::drawTowers(const TowerManager& towerManager, int cellSize) {
-    const std::vector<Tower*>& towers = towerManager.getTowers();
-    for (const Tower* tower : towers) {
-        TowerUI::drawTower(tower, cellSize);
+// Draw the labels of all towers.
+void TowerUIManager::drawTowerLabels(const RenderSnapshot& snapshot, int cellSize) {
+    for (const TowerView& tower : snapshot.towers) {
+        TowerUI::drawTowerLabels(tower, cellSize);
     }
 }
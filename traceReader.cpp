@@ -0,0 +1,293 @@
+#include "traceReader.h"
+#include <cstring>
+#include "logger.h"
+
+static bool readBytes(std::ifstream& in, unsigned char* bytes, std::size_t count) {
+    in.read(reinterpret_cast<char*>(bytes), count);
+    return static_cast<std::size_t>(in.gcount()) == count;
+}
+
+static uint32_t getUint32(const unsigned char* bytes) {
+    return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+}
+
+// Undoes TraceWriter's delta, zigzag and varint steps. Returns false if the bytes run out.
+static bool getColumn(const unsigned char*& at, const unsigned char* end, std::size_t count,
+                      const int32_t* matches, std::vector<int32_t>& column) {
+    column.clear();
+    column.reserve(count);
+    int64_t previous = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        uint64_t bits = 0;
+        int shift = 0;
+        for (;;) {
+            if (at == end || shift > 63) {
+                return false;
+            }
+            unsigned char byte = *at++;
+            bits |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            shift += 7;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        int64_t delta = static_cast<int64_t>(bits >> 1) ^ -static_cast<int64_t>(bits & 1);
+        // Matched rows always lie in the tick before, which is decoded already
+        int64_t base = matches && matches[i] >= 0 ? column[matches[i]] : previous;
+        previous = base + delta;
+        column.push_back(static_cast<int32_t>(previous));
+    }
+    return true;
+}
+
+TraceReader::TraceReader()
+    : fileSize(0), positionScale(1.0f), error(false), firstTick(0), chunkTicks(0), tickIndex(0),
+    critterIndex(0), towerIndex(0), bulletIndex(0) {}
+
+bool TraceReader::open(const std::string& fileName) {
+    in.close();
+    in.clear();
+    error = false;
+    chunkTicks = 0;
+    tickIndex = 0;
+    in.open(fileName, std::ios::binary | std::ios::ate);
+    if (!in) {
+        LOG_ERROR("Cannot open trace {}", fileName);
+        return false;
+    }
+    fileSize = in.tellg();
+    in.seekg(0);
+    if (fileSize < 0) {
+        LOG_ERROR("Cannot read trace {}", fileName);
+        return false;
+    }
+    unsigned char header[sizeof(traceMagic) + 4];
+    if (!readBytes(in, header, sizeof(header)) || std::memcmp(header, traceMagic, sizeof(traceMagic)) != 0) {
+        LOG_ERROR("{} is not a trace file", fileName);
+        return false;
+    }
+    uint32_t scale = getUint32(header + sizeof(traceMagic));
+    positionScale = scale > 0 ? static_cast<float>(scale) : 1.0f;
+    return true;
+}
+
+bool TraceReader::hasError() const {
+    return error;
+}
+
+// True if the rows per tick are never negative and add up to the chunk's total.
+static bool countsAddUp(const std::vector<int32_t>& counts, uint64_t total) {
+    uint64_t sum = 0;
+    for (int32_t count : counts) {
+        if (count < 0) {
+            return false;
+        }
+        sum += static_cast<uint64_t>(count);
+    }
+    return sum == total;
+}
+
+bool TraceReader::readChunk() {
+    unsigned char header[24];
+    in.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (in.gcount() == 0) {
+        return false;  // Clean end of the file
+    }
+    if (static_cast<std::size_t>(in.gcount()) != sizeof(header)) {
+        error = true;
+        return false;
+    }
+    firstTick = static_cast<long long>(uint64_t(getUint32(header)) | uint64_t(getUint32(header + 4)) << 32);
+    uint32_t ticks = getUint32(header + 8);
+    uint32_t critters = getUint32(header + 12);
+    uint32_t towers = getUint32(header + 16);
+    uint32_t bullets = getUint32(header + 20);
+    std::size_t counts[TRACE_COLUMN_COUNT];
+    for (int column = TRACE_TICK; column <= TRACE_BULLET_COUNT; column++) {
+        counts[column] = ticks;
+    }
+    for (int column = TRACE_CRITTER_ID; column <= TRACE_CRITTER_HEALTH; column++) {
+        counts[column] = critters;
+    }
+    for (int column = TRACE_TOWER_ID; column <= TRACE_TOWER_COOLDOWN; column++) {
+        counts[column] = towers;
+    }
+    for (int column = TRACE_BULLET_TOWER; column <= TRACE_BULLET_Y; column++) {
+        counts[column] = bullets;
+    }
+
+    // Nothing is allocated until the header checks out: the payload has to fit in what is
+    // left of the file, and every value takes at least one byte of it
+    unsigned char sizeBytes[4];
+    if (!readBytes(in, sizeBytes, sizeof(sizeBytes))) {
+        error = true;
+        return false;
+    }
+    uint64_t payloadBytes = getUint32(sizeBytes);
+    uint64_t valueCount = 0;
+    for (std::size_t count : counts) {
+        valueCount += count;
+    }
+    std::streamoff position = in.tellg();
+    if (ticks == 0 || ticks > static_cast<uint32_t>(INT32_MAX) || position < 0 ||
+        payloadBytes > static_cast<uint64_t>(fileSize - position) || valueCount > payloadBytes) {
+        error = true;
+        return false;
+    }
+    chunkTicks = static_cast<int>(ticks);
+    payload.resize(static_cast<std::size_t>(payloadBytes));
+    if (!readBytes(in, payload.data(), payload.size())) {
+        error = true;
+        return false;
+    }
+    const unsigned char* at = payload.data();
+    const unsigned char* end = at + payload.size();
+    for (int column = 0; column < TRACE_COLUMN_COUNT; column++) {
+        const int32_t* matches = nullptr;
+        if (column >= TRACE_CRITTER_X && column <= TRACE_CRITTER_HEALTH) {
+            matches = critterMatches.data();
+        }
+        else if (column >= TRACE_TOWER_TARGET && column <= TRACE_TOWER_COOLDOWN) {
+            matches = towerMatches.data();
+        }
+        if (!getColumn(at, end, counts[column], matches, columns[column])) {
+            error = true;
+            return false;
+        }
+        // The per-tick rows have to add up before anything is indexed by them
+        if (column == TRACE_BULLET_COUNT &&
+            (!countsAddUp(columns[TRACE_CRITTER_COUNT], critters) || !countsAddUp(columns[TRACE_TOWER_COUNT], towers) ||
+             !countsAddUp(columns[TRACE_BULLET_COUNT], bullets))) {
+            error = true;
+            return false;
+        }
+        // The id columns come first, so their matches are ready for the columns after them
+        if (column == TRACE_CRITTER_ID) {
+            matchTraceRows(columns[column], columns[TRACE_CRITTER_COUNT], critterMatches);
+        }
+        else if (column == TRACE_TOWER_ID) {
+            matchTraceRows(columns[column], columns[TRACE_TOWER_COUNT], towerMatches);
+        }
+    }
+    tickIndex = 0;
+    critterIndex = 0;
+    towerIndex = 0;
+    bulletIndex = 0;
+    return true;
+}
+
+bool TraceReader::next(TraceTick& tick) {
+    if (error || !in.is_open()) {
+        return false;
+    }
+    while (tickIndex >= chunkTicks) {
+        if (!readChunk()) {
+            return false;
+        }
+    }
+    tick.tick = firstTick + columns[TRACE_TICK][tickIndex];
+    std::size_t critterCount = columns[TRACE_CRITTER_COUNT][tickIndex];
+    std::size_t towerCount = columns[TRACE_TOWER_COUNT][tickIndex];
+    std::size_t bulletCount = columns[TRACE_BULLET_COUNT][tickIndex];
+    tickIndex++;
+    // Per-tick counts that overrun the chunk's columns mean the chunk is damaged
+    if (critterIndex + critterCount > columns[TRACE_CRITTER_ID].size() ||
+        towerIndex + towerCount > columns[TRACE_TOWER_ID].size() ||
+        bulletIndex + bulletCount > columns[TRACE_BULLET_TOWER].size()) {
+        error = true;
+        return false;
+    }
+
+    tick.critters.resize(critterCount);
+    for (TraceCritter& critter : tick.critters) {
+        critter.id = columns[TRACE_CRITTER_ID][critterIndex];
+        critter.x = columns[TRACE_CRITTER_X][critterIndex] / positionScale;
+        critter.y = columns[TRACE_CRITTER_Y][critterIndex] / positionScale;
+        critter.health = columns[TRACE_CRITTER_HEALTH][critterIndex];
+        critterIndex++;
+    }
+    tick.towers.resize(towerCount);
+    for (TraceTower& tower : tick.towers) {
+        tower.id = columns[TRACE_TOWER_ID][towerIndex];
+        tower.targetId = columns[TRACE_TOWER_TARGET][towerIndex];
+        tower.cooldownLeft = columns[TRACE_TOWER_COOLDOWN][towerIndex];
+        towerIndex++;
+    }
+    tick.bullets.resize(bulletCount);
+    for (TraceBullet& bullet : tick.bullets) {
+        bullet.towerId = columns[TRACE_BULLET_TOWER][bulletIndex];
+        bullet.x = columns[TRACE_BULLET_X][bulletIndex] / positionScale;
+        bullet.y = columns[TRACE_BULLET_Y][bulletIndex] / positionScale;
+        bulletIndex++;
+    }
+    return true;
+}
+
+bool TraceReader::writeCsv(std::ostream& out, const std::string& table) {
+    if (table == "critters") {
+        out << "tick,critter,x,y,health\n";
+    }
+    else if (table == "towers") {
+        out << "tick,tower,target,cooldown\n";
+    }
+    else if (table == "bullets") {
+        out << "tick,tower,x,y\n";
+    }
+    else {
+        LOG_ERROR("Unknown trace table {}", table);
+        return false;
+    }
+    TraceTick tick;
+    tick.tick = 0;
+    while (next(tick)) {
+        if (table == "critters") {
+            for (const TraceCritter& critter : tick.critters) {
+                out << tick.tick << "," << critter.id << "," << critter.x << "," << critter.y << "," << critter.health << "\n";
+            }
+        }
+        else if (table == "towers") {
+            for (const TraceTower& tower : tick.towers) {
+                out << tick.tick << "," << tower.id << "," << tower.targetId << "," << tower.cooldownLeft << "\n";
+            }
+        }
+        else {
+            for (const TraceBullet& bullet : tick.bullets) {
+                out << tick.tick << "," << bullet.towerId << "," << bullet.x << "," << bullet.y << "\n";
+            }
+        }
+    }
+    if (hasError()) {
+        LOG_ERROR("Trace is damaged after tick {}", tick.tick);
+        return false;
+    }
+    return true;
+}
+
+static void printTraceDumpUsage() {
+    std::cerr << "Usage: --trace-dump <trace file> [--table critters|towers|bullets]\n";
+}
+
+int runTraceDumpCommand(int argc, char** argv) {
+    if (argc < 1) {
+        printTraceDumpUsage();
+        return 1;
+    }
+    std::string fileName = argv[0];
+    std::string table = "critters";
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--table" && i + 1 < argc) {
+            table = argv[++i];
+        }
+        else {
+            printTraceDumpUsage();
+            return 1;
+        }
+    }
+
+    Logger::setLevel(LogLevel::WARN);
+    TraceReader reader;
+    bool dumped = reader.open(fileName) && reader.writeCsv(std::cout, table);
+    Logger::flush();
+    return dumped ? 0 : 1;
+}
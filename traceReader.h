@@ -0,0 +1,80 @@
+#pragma once
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "traceWriter.h"
+
+struct TraceCritter {
+    int id;
+    float x;  // Pixels
+    float y;
+    int health;
+};
+
+struct TraceTower {
+    int id;
+    int targetId;      // -1 before the tower's first shot
+    int cooldownLeft;  // Ticks
+};
+
+struct TraceBullet {
+    int towerId;
+    float x;  // Pixels
+    float y;
+};
+
+// Everything a trace holds about one tick.
+struct TraceTick {
+    long long tick;
+    std::vector<TraceCritter> critters;
+    std::vector<TraceTower> towers;
+    std::vector<TraceBullet> bullets;
+};
+
+// Reads a file written by TraceWriter back one tick at a time, decoding a chunk at a time.
+// Analysis code loops "while (reader.next(tick))" and checks hasError() afterwards.
+class TraceReader {
+public:
+    TraceReader();
+
+    // Returns false if the file is missing or is not a trace.
+    bool open(const std::string& fileName);
+    // Fills tick with the next recorded tick. Returns false at the end or at a damaged chunk.
+    bool next(TraceTick& tick);
+    // True if reading stopped at a damaged or cut-off chunk rather than the end of the file.
+    bool hasError() const;
+
+    // Dumps one table of a trace as CSV: "critters", "towers" or "bullets".
+    // Returns false for an unknown table or a damaged trace.
+    bool writeCsv(std::ostream& out, const std::string& table);
+
+private:
+    std::ifstream in;
+    std::streamoff fileSize;
+    float positionScale;
+    bool error;
+    long long firstTick;
+    int chunkTicks;
+    int tickIndex;
+    std::size_t critterIndex;
+    std::size_t towerIndex;
+    std::size_t bulletIndex;
+    std::vector<int32_t> columns[TRACE_COLUMN_COUNT];
+    std::vector<int32_t> critterMatches;
+    std::vector<int32_t> towerMatches;
+    std::vector<unsigned char> payload;
+
+    bool readChunk();
+};
+
+// Entry point for "--trace-dump": prints a table of a trace file as CSV.
+// Returns the process exit code.
+int runTraceDumpCommand(int argc, char** argv);
+
+#endif
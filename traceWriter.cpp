@@ -0,0 +1,292 @@
+#include "traceWriter.h"
+#include <cmath>
+#include "logger.h"
+
+void TraceChunk::clear() {
+    firstTick = 0;
+    ticks = 0;
+    for (std::vector<int32_t>& column : columns) {
+        column.clear();
+    }
+}
+
+std::size_t TraceChunk::valueCount() const {
+    std::size_t count = 0;
+    for (const std::vector<int32_t>& column : columns) {
+        count += column.size();
+    }
+    return count;
+}
+
+static int32_t tracePosition(float pixels) {
+    return static_cast<int32_t>(std::lround(pixels * TraceWriter::positionScale));
+}
+
+static void putUint32(std::vector<unsigned char>& bytes, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        bytes.push_back(static_cast<unsigned char>(value >> (8 * i)));
+    }
+}
+
+static void putUint64(std::vector<unsigned char>& bytes, uint64_t value) {
+    putUint32(bytes, static_cast<uint32_t>(value));
+    putUint32(bytes, static_cast<uint32_t>(value >> 32));
+}
+
+// A difference of two int32 values needs 33 bits, so at most 5 varint bytes
+static const std::size_t maxVarintBytes = 5;
+
+void matchTraceRows(const std::vector<int32_t>& ids, const std::vector<int32_t>& counts, std::vector<int32_t>& matches) {
+    matches.resize(ids.size());
+    std::size_t start = 0;
+    std::size_t previousStart = 0;
+    std::size_t previousEnd = 0;
+    for (int32_t count : counts) {
+        std::size_t scan = previousStart;
+        for (std::size_t row = start; row < start + count; row++) {
+            while (scan < previousEnd && ids[scan] < ids[row]) {
+                scan++;
+            }
+            matches[row] = scan < previousEnd && ids[scan] == ids[row] ? static_cast<int32_t>(scan) : -1;
+        }
+        previousStart = start;
+        previousEnd = start + count;
+        start = previousEnd;
+    }
+}
+
+// matches is null for columns that are not per critter or per tower
+static void putColumn(std::vector<unsigned char>& bytes, const std::vector<int32_t>& column, const int32_t* matches) {
+    std::size_t start = bytes.size();
+    bytes.resize(start + column.size() * maxVarintBytes);
+    unsigned char* at = bytes.data() + start;
+    int64_t previous = 0;
+    for (std::size_t i = 0; i < column.size(); i++) {
+        int32_t value = column[i];
+        int64_t base = matches && matches[i] >= 0 ? column[matches[i]] : previous;
+        int64_t delta = value - base;
+        previous = value;
+        // Zigzag, so small negative steps stay small too
+        uint64_t bits = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+        while (bits >= 0x80) {
+            *at++ = static_cast<unsigned char>(bits | 0x80);
+            bits >>= 7;
+        }
+        *at++ = static_cast<unsigned char>(bits);
+    }
+    bytes.resize(at - bytes.data());
+}
+
+// Grows a column by count values and returns where they go, so the loops below do not
+// check capacity once per value.
+static int32_t* extend(std::vector<int32_t>& column, std::size_t count) {
+    std::size_t start = column.size();
+    column.resize(start + count);
+    return column.data() + start;
+}
+
+TraceWriter::TraceWriter() : current(nullptr), queued(0), running(false), failed(false), stalls(0), bytesWritten(0) {}
+
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+bool TraceWriter::open(const std::string& fileName) {
+    close();
+    out.open(fileName, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        LOG_ERROR("Cannot write trace {}", fileName);
+        return false;
+    }
+    std::vector<unsigned char> header(traceMagic, traceMagic + sizeof(traceMagic));
+    putUint32(header, positionScale);
+    out.write(reinterpret_cast<const char*>(header.data()), header.size());
+    bytesWritten = static_cast<long long>(header.size());
+    failed.store(false, std::memory_order_relaxed);
+    stalls.store(0, std::memory_order_relaxed);
+
+    // The spare queue is filled before the worker starts, which then becomes its only producer
+    TraceChunk* chunk;
+    while (spare.pop(chunk)) {
+    }
+    for (std::size_t i = 1; i < chunkCount; i++) {
+        chunks[i].clear();
+        spare.push(&chunks[i]);
+    }
+    current = &chunks[0];
+    current->clear();
+    queued.store(0, std::memory_order_relaxed);
+    running.store(true, std::memory_order_release);
+    worker = std::thread(&TraceWriter::run, this);
+    return true;
+}
+
+bool TraceWriter::isOpen() const {
+    return current != nullptr;
+}
+
+void TraceWriter::record(long long tick, const CritterManager& critterManager, const TowerManager& towerManager, int cellSize) {
+    if (!current) {
+        return;
+    }
+    TraceChunk& chunk = *current;
+    if (chunk.ticks == 0) {
+        chunk.firstTick = tick;
+    }
+    std::vector<int32_t>* columns = chunk.columns;
+
+    const CritterList& critters = critterManager.getCritters();
+    columns[TRACE_TICK].push_back(static_cast<int32_t>(tick - chunk.firstTick));
+    columns[TRACE_CRITTER_COUNT].push_back(static_cast<int32_t>(critters.size()));
+    int32_t* ids = extend(columns[TRACE_CRITTER_ID], critters.size());
+    int32_t* xs = extend(columns[TRACE_CRITTER_X], critters.size());
+    int32_t* ys = extend(columns[TRACE_CRITTER_Y], critters.size());
+    int32_t* healths = extend(columns[TRACE_CRITTER_HEALTH], critters.size());
+    for (std::size_t i = 0; i < critters.size(); i++) {
+        const CritterLogic* critter = critters[i];
+        Vector2 position = toVector2(critter->getPosition(cellSize));
+        ids[i] = critter->getId();
+        xs[i] = tracePosition(position.x);
+        ys[i] = tracePosition(position.y);
+        healths[i] = critter->getHealth();
+    }
+
+    const TowerList& towers = towerManager.getTowers();
+    int32_t bulletCount = 0;
+    columns[TRACE_TOWER_COUNT].push_back(static_cast<int32_t>(towers.size()));
+    int32_t* towerIds = extend(columns[TRACE_TOWER_ID], towers.size());
+    int32_t* targets = extend(columns[TRACE_TOWER_TARGET], towers.size());
+    int32_t* cooldowns = extend(columns[TRACE_TOWER_COOLDOWN], towers.size());
+    for (std::size_t i = 0; i < towers.size(); i++) {
+        const Tower* tower = towers[i];
+        int32_t id = static_cast<int32_t>(towerManager.getTowerIdAt(i));
+        towerIds[i] = id;
+        targets[i] = tower->getTargetId();
+        cooldowns[i] = towerManager.getCooldownLeft(*tower);
+        for (const Bullet& bullet : tower->getBullets()) {
+            if (!bullet.active) {
+                continue;
+            }
+            Vector2 position = toVector2(bullet.position);
+            columns[TRACE_BULLET_TOWER].push_back(id);
+            columns[TRACE_BULLET_X].push_back(tracePosition(position.x));
+            columns[TRACE_BULLET_Y].push_back(tracePosition(position.y));
+            bulletCount++;
+        }
+    }
+    columns[TRACE_BULLET_COUNT].push_back(bulletCount);
+
+    chunk.ticks++;
+    if (chunk.ticks >= maxChunkTicks || chunk.valueCount() >= maxChunkValues) {
+        handOff();
+    }
+}
+
+// Only as many chunks exist as the filled queue holds, so the push always succeeds
+void TraceWriter::handOff() {
+    filled.push(current);
+    queued.fetch_add(1, std::memory_order_release);
+    {
+        // Taking the lock orders this with the worker's check, so the wakeup is never lost
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wake.notify_one();
+    TraceChunk* next;
+    if (!spare.pop(next)) {
+        stalls.fetch_add(1, std::memory_order_relaxed);
+        while (!spare.pop(next)) {
+            std::this_thread::yield();
+        }
+    }
+    next->clear();
+    current = next;
+}
+
+bool TraceWriter::close() {
+    if (!current) {
+        return !failed.load(std::memory_order_acquire);
+    }
+    if (current->ticks > 0) {
+        filled.push(current);
+    }
+    current = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        running.store(false, std::memory_order_release);
+    }
+    wake.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    out.close();
+    if (failed.load(std::memory_order_acquire)) {
+        LOG_ERROR("Trace write failed after {} bytes", bytesWritten);
+        return false;
+    }
+    return true;
+}
+
+std::size_t TraceWriter::getStallCount() const {
+    return stalls.load(std::memory_order_relaxed);
+}
+
+long long TraceWriter::getBytesWritten() const {
+    return bytesWritten;
+}
+
+void TraceWriter::run() {
+    for (;;) {
+        // Read the flag first: whatever close queued before clearing it is drained below
+        bool stopping = !running.load(std::memory_order_acquire);
+        TraceChunk* chunk;
+        while (filled.pop(chunk)) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            writeChunk(*chunk);
+            spare.push(chunk);
+        }
+        if (stopping) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wake.wait(lock, [this] {
+            return queued.load(std::memory_order_acquire) > 0 || !running.load(std::memory_order_acquire);
+        });
+    }
+}
+
+void TraceWriter::writeChunk(const TraceChunk& chunk) {
+    if (failed.load(std::memory_order_relaxed)) {
+        return;
+    }
+    encoded.clear();
+    putUint64(encoded, static_cast<uint64_t>(chunk.firstTick));
+    putUint32(encoded, static_cast<uint32_t>(chunk.ticks));
+    putUint32(encoded, static_cast<uint32_t>(chunk.columns[TRACE_CRITTER_ID].size()));
+    putUint32(encoded, static_cast<uint32_t>(chunk.columns[TRACE_TOWER_ID].size()));
+    putUint32(encoded, static_cast<uint32_t>(chunk.columns[TRACE_BULLET_TOWER].size()));
+    std::size_t sizeAt = encoded.size();
+    putUint32(encoded, 0);
+    matchTraceRows(chunk.columns[TRACE_CRITTER_ID], chunk.columns[TRACE_CRITTER_COUNT], critterMatches);
+    matchTraceRows(chunk.columns[TRACE_TOWER_ID], chunk.columns[TRACE_TOWER_COUNT], towerMatches);
+    for (int column = 0; column < TRACE_COLUMN_COUNT; column++) {
+        const int32_t* matches = nullptr;
+        if (column >= TRACE_CRITTER_X && column <= TRACE_CRITTER_HEALTH) {
+            matches = critterMatches.data();
+        }
+        else if (column >= TRACE_TOWER_TARGET && column <= TRACE_TOWER_COOLDOWN) {
+            matches = towerMatches.data();
+        }
+        putColumn(encoded, chunk.columns[column], matches);
+    }
+    uint32_t payloadBytes = static_cast<uint32_t>(encoded.size() - sizeAt - 4);
+    for (int i = 0; i < 4; i++) {
+        encoded[sizeAt + i] = static_cast<unsigned char>(payloadBytes >> (8 * i));
+    }
+
+    out.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+    if (!out) {
+        failed.store(true, std::memory_order_release);
+        return;
+    }
+    bytesWritten += static_cast<long long>(encoded.size());
+}
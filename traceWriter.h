@@ -0,0 +1,120 @@
+#pragma once
+#ifndef TRACE_WRITER_H
+#define TRACE_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "critterLogic.h"
+#include "towerLogic.h"
+#include "spscQueue.h"
+
+// ---------- Trace file format ----------
+// A header, then chunks that each hold a run of whole ticks and decode on their own:
+//   header: "TDTRACE1", uint32 positionScale
+//   chunk:  uint64 firstTick, uint32 ticks, uint32 critters, uint32 towers, uint32 bullets,
+//           uint32 payloadBytes, payload
+// All integers are little endian. The payload stores the TraceColumn columns in order, each
+// value as a difference, zigzag and varint encoded, so slowly changing columns shrink to a
+// byte or two per value. A critter or tower value is taken off the same id's value in the
+// previous tick of the chunk (see matchTraceRows); every other value, and one with no such
+// id, off the value before it in its column (0 before the first).
+// Positions are pixels times positionScale, rounded.
+
+// Columns of one chunk. The first four hold one value per tick, the critter columns one per
+// critter per tick, and so on, all in tick order.
+enum TraceColumn {
+    TRACE_TICK,            // Offset from the chunk's firstTick
+    TRACE_CRITTER_COUNT,
+    TRACE_TOWER_COUNT,
+    TRACE_BULLET_COUNT,
+    TRACE_CRITTER_ID,
+    TRACE_CRITTER_X,
+    TRACE_CRITTER_Y,
+    TRACE_CRITTER_HEALTH,  // Of the swarm's lead member
+    TRACE_TOWER_ID,
+    TRACE_TOWER_TARGET,    // Critter the tower fired at last, -1 before its first shot
+    TRACE_TOWER_COOLDOWN,  // Ticks until it can fire again
+    TRACE_BULLET_TOWER,
+    TRACE_BULLET_X,
+    TRACE_BULLET_Y,
+    TRACE_COLUMN_COUNT
+};
+
+const char traceMagic[8] = { 'T', 'D', 'T', 'R', 'A', 'C', 'E', '1' };
+
+// For every row of an id column, the row holding the same id in the previous tick, or -1.
+// counts holds the rows per tick. Critters are listed in spawn order, so one merge walk per
+// tick finds them; ids in any other order are only matched less often.
+void matchTraceRows(const std::vector<int32_t>& ids, const std::vector<int32_t>& counts, std::vector<int32_t>& matches);
+
+// Ticks recorded but not yet written.
+struct TraceChunk {
+    long long firstTick;
+    int ticks;
+    std::vector<int32_t> columns[TRACE_COLUMN_COUNT];
+
+    void clear();
+    std::size_t valueCount() const;
+};
+
+// Records where every critter and bullet is and what every tower targets, tick by tick.
+// The simulation thread only copies numbers into a chunk; full chunks go to a background
+// thread that encodes and writes them, so tracing can stay on in soak tests.
+class TraceWriter {
+public:
+    static const int positionScale = 16;
+    // A chunk is handed off after this many ticks, or sooner once it holds maxChunkValues
+    static const int maxChunkTicks = 64;
+    static const std::size_t maxChunkValues = 1 << 20;
+
+    TraceWriter();
+    ~TraceWriter();
+
+    // Starts a new trace file. Returns false if it cannot be created.
+    bool open(const std::string& fileName);
+    bool isOpen() const;
+    // Call once per tick after the tick ran. Does nothing while no file is open.
+    void record(long long tick, const CritterManager& critterManager, const TowerManager& towerManager, int cellSize);
+    // Writes the ticks recorded so far and closes the file. Returns false if a write failed.
+    bool close();
+
+    // Times record had to wait because the background thread fell behind.
+    std::size_t getStallCount() const;
+    // Only once closed.
+    long long getBytesWritten() const;
+
+private:
+    static const std::size_t chunkCount = 8;  // Power of two, for the queues
+
+    TraceChunk chunks[chunkCount];
+    TraceChunk* current;  // Being filled by record; null while closed
+    SpscQueue<TraceChunk*, chunkCount> filled;  // Waiting for the background thread
+    SpscQueue<TraceChunk*, chunkCount> spare;   // Written and ready to be filled again
+    std::ofstream out;
+    std::thread worker;
+    // The worker sleeps until a chunk is handed off, once per chunk rather than per tick
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<std::size_t> queued;
+    std::atomic<bool> running;
+    std::atomic<bool> failed;
+    std::atomic<std::size_t> stalls;
+    long long bytesWritten;
+    // Background thread only
+    std::vector<unsigned char> encoded;
+    std::vector<int32_t> critterMatches;
+    std::vector<int32_t> towerMatches;
+
+    void handOff();
+    void run();
+    void writeChunk(const TraceChunk& chunk);
+};
+
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Hands whole values from one producer thread to one consumer thread without locks.
+// The producer fills its own buffer and swaps it into the middle slot; the consumer
+// swaps the middle slot out whenever it holds something newer. Neither side ever
+// waits, and the consumer always sees a complete value, possibly skipping some.
+template <class T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle(1), back(0), front(2) {}
+
+    // Producer only: the buffer to fill before calling publish().
+    T& writeBuffer() { return buffers[back]; }
+
+    // Producer only: makes the write buffer the newest value and takes back an older one.
+    void publish() {
+        int previous = middle.exchange(back | freshBit, std::memory_order_acq_rel);
+        back = previous & indexMask;
+    }
+
+    // Consumer only: the newest published value. Stays valid until the next call.
+    const T& read() {
+        if (middle.load(std::memory_order_relaxed) & freshBit) {
+            int previous = middle.exchange(front, std::memory_order_acq_rel);
+            front = previous & indexMask;
+        }
+        return buffers[front];
+    }
+
+private:
+    static const int freshBit = 4;
+    static const int indexMask = 3;
+
+    T buffers[3];
+    std::atomic<int> middle;  // Index of the hand-over buffer, plus freshBit if unread
+    int back;                 // Producer's buffer
+    int front;                // Consumer's buffer
+};
+
+#endif
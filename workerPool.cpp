@@ -0,0 +1,73 @@
+#include "workerPool.h"
+
+WorkerPool::WorkerPool(int threadCount)
+    : job(nullptr), jobCount(0), jobGeneration(0), busyWorkers(0), stopping(false), nextIndex(0) {
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    for (int i = 1; i < threadCount; i++) {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+int WorkerPool::getThreadCount() const {
+    return static_cast<int>(workers.size()) + 1;
+}
+
+void WorkerPool::parallelFor(int count, const std::function<void(int)>& work) {
+    if (workers.empty() || count <= 1) {
+        for (int i = 0; i < count; i++) {
+            work(i);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &work;
+        jobCount = count;
+        nextIndex = 0;
+        busyWorkers = static_cast<int>(workers.size());
+        jobGeneration++;
+    }
+    wake.notify_all();
+    runJob();
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busyWorkers == 0; });
+    job = nullptr;
+}
+
+void WorkerPool::runJob() {
+    for (int i = nextIndex++; i < jobCount; i = nextIndex++) {
+        (*job)(i);
+    }
+}
+
+void WorkerPool::workerLoop() {
+    unsigned int seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seenGeneration] { return stopping || jobGeneration != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = jobGeneration;
+        }
+        runJob();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0) {
+            done.notify_one();
+        }
+    }
+}
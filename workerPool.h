@@ -0,0 +1,42 @@
+#pragma once
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads that runs one parallel loop at a time. The calling thread
+// joins in, so a pool of N threads starts N - 1 workers, and a pool of 1 runs inline.
+class WorkerPool {
+public:
+    // threadCount 0 = one per core.
+    explicit WorkerPool(int threadCount);
+    ~WorkerPool();
+
+    int getThreadCount() const;
+    // Calls work(i) once for every i in [0, count) and returns when all calls are done.
+    // Indices are handed out dynamically, so work must not depend on which thread runs it.
+    // Not reentrant: work must not call parallelFor on the same pool.
+    void parallelFor(int count, const std::function<void(int)>& work);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int)>* job;
+    int jobCount;
+    unsigned int jobGeneration;
+    int busyWorkers;
+    bool stopping;
+    std::atomic<int> nextIndex;
+
+    void runJob();
+    void workerLoop();
+};
+
+#endif